@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+/*
+ * Checks the link busy time prefix sums against a direct union of the
+ * transmission intervals, including nested and overlapping ones, and
+ * measures the cost of playback queries.
+ *
+ * usage: busy-time-bench [packets] [links]
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <vector>
+#include <sys/time.h>
+
+#include "common.h"
+#include "nam-busy-time.h"
+
+static double
+GetTime (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+static double
+Random (double from, double to)
+{
+  return from + (to - from) * rand () / RAND_MAX;
+}
+
+static bool
+CompareFirstBit (const Packet &a, const Packet &b)
+{
+  return a.GetFirstBitTx () < b.GetFirstBitTx ();
+}
+
+// length of the union of the series intervals up to time, quadratic
+static double
+GetUnionTime (const std::vector<Packet> &packets, uint32_t series, double time)
+{
+  std::vector<std::pair<double, double> > intervals;
+  for (uint32_t i = 0; i < packets.size (); ++i)
+    {
+      if (packets[i].GetSeries () == series && packets[i].GetFirstBitTx () < time)
+        {
+          intervals.push_back (std::make_pair (packets[i].GetFirstBitTx (),
+                                               std::min (time, packets[i].GetLastBitTx ())));
+        }
+    }
+  std::sort (intervals.begin (), intervals.end ());
+
+  double busy = 0;
+  double last = 0;
+  for (uint32_t i = 0; i < intervals.size (); ++i)
+    {
+      double start = std::max (intervals[i].first, last);
+      double end = std::max (intervals[i].second, start);
+      busy += end - start;
+      last = end;
+    }
+  return busy;
+}
+
+static uint32_t
+Check (const std::vector<Packet> &packets, uint32_t series, const double *times, uint32_t count, const double *expected)
+{
+  uint32_t seriesCount = series + 1;
+  for (uint32_t i = 0; i < packets.size (); ++i)
+    {
+      seriesCount = std::max (seriesCount, packets[i].GetSeries () + 1);
+    }
+  NamBusyTime busy;
+  busy.Build (packets, seriesCount);
+
+  uint32_t mismatches = 0;
+  uint32_t cursor = busy.GetCursor (series);
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      double value = busy.GetBusyTime (series, times[i], cursor);
+      if (std::fabs (value - expected[i]) > 1E-6)
+        {
+          printf ("series %u at %g: busy %g, expected %g\n", series, times[i], value, expected[i]);
+          ++mismatches;
+        }
+    }
+  return mismatches;
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t packetCount = argc > 1 ? atoi (argv[1]) : 1000000;
+  uint32_t links = argc > 2 ? atoi (argv[2]) : 1000;
+  uint32_t mismatches = 0;
+
+  // [0, 10] contains [5, 6]
+  std::vector<Packet> packets;
+  packets.push_back (Packet (0, 0, 0, 10, 0, 10));
+  packets.push_back (Packet (0, 0, 5, 6, 5, 6));
+  double nestedTimes[] = { 3, 5.5, 7, 10, 12 };
+  double nestedBusy[] = { 3, 5.5, 7, 10, 10 };
+  mismatches += Check (packets, 0, nestedTimes, 5, nestedBusy);
+
+  // [0, 4] overlaps [2, 6], [1, 3] lies in both, [8, 9] is apart
+  packets.clear ();
+  packets.push_back (Packet (0, 1, 0, 4, 0, 4));
+  packets.push_back (Packet (0, 1, 1, 3, 1, 3));
+  packets.push_back (Packet (0, 1, 2, 6, 2, 6));
+  packets.push_back (Packet (0, 1, 8, 9, 8, 9));
+  double overlapTimes[] = { 0.5, 2.5, 3.5, 5, 7, 8.5, 10 };
+  double overlapBusy[] = { 0.5, 2.5, 3.5, 5, 6, 6.5, 7 };
+  mismatches += Check (packets, 1, overlapTimes, 7, overlapBusy);
+
+  // random transmissions, several in flight on each link direction
+  packets.clear ();
+  uint32_t series = 2 * links;
+  double duration = packetCount / 100.0;
+  for (uint32_t i = 0; i < packetCount; ++i)
+    {
+      double tx = Random (0, duration);
+      double lbTx = tx + Random (0, 20);
+      packets.push_back (Packet (rand () % links, rand () % 2, tx, lbTx, tx + 1, lbTx + 1));
+    }
+  std::sort (packets.begin (), packets.end (), CompareFirstBit);
+
+  NamBusyTime busy;
+  double start = GetTime ();
+  busy.Build (packets, series);
+  double build = GetTime () - start;
+
+  // sampled series against the direct union
+  std::vector<Packet> sample;
+  for (uint32_t i = 0; i < packets.size () && sample.size () < 20000; ++i)
+    {
+      if (packets[i].GetSeries () < 4)
+        {
+          sample.push_back (packets[i]);
+        }
+    }
+  for (uint32_t s = 0; s < 4; ++s)
+    {
+      std::vector<double> times;
+      std::vector<double> expected;
+      for (double time = 0; time < duration; time += duration / 97)
+        {
+          times.push_back (time);
+          expected.push_back (GetUnionTime (sample, s, time));
+        }
+      mismatches += Check (sample, s, &times[0], times.size (), &expected[0]);
+    }
+
+  // playback, every series queried at every frame
+  std::vector<uint32_t> cursors (series);
+  for (uint32_t s = 0; s < series; ++s)
+    {
+      cursors[s] = busy.GetCursor (s);
+    }
+  uint32_t frames = 1000;
+  double sum = 0;
+  start = GetTime ();
+  for (uint32_t f = 0; f < frames; ++f)
+    {
+      double time = duration * f / frames;
+      for (uint32_t s = 0; s < series; ++s)
+        {
+          sum += busy.GetBusyTime (s, time, cursors[s]);
+        }
+    }
+  double playback = GetTime () - start;
+
+  printf ("packets %u, series %u\n", packetCount, series);
+  printf ("build    %8.3f ms\n", build * 1000);
+  printf ("playback %8.3f ns/query\n", playback * 1E9 / frames / series);
+  printf ("checksum %g, mismatches %u\n", sum, mismatches);
+  return mismatches != 0;
+}
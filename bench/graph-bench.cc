@@ -0,0 +1,380 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+/*
+ * Measures creation, iteration, traversal, marker and file operations of
+ * the graph library on a random graph.
+ *
+ * usage: graph-bench [nodes] [edges per node]
+ */
+
+#include <cstdio>
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "graph.h"
+#include "parallel-bfs.h"
+#include "side-table.h"
+#include "snapshot.h"
+#include "traversal.h"
+
+using namespace graph;
+
+static double
+GetTime (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+static void
+Report (const char *name, double time, size_t count)
+{
+  printf ("%-16s %9.2f ms %8.2f ns/item\n", name, time * 1000, time * 1E9 / count);
+}
+
+static size_t
+GetListSize (NodeListItem *list)
+{
+  size_t size = 0;
+  for (; list; list = list->GetNext ())
+    {
+      size++;
+    }
+  return size;
+}
+
+/**
+ * \brief breadth-first searches from every stride-th source, run by one thread
+ */
+struct Queries
+{
+  const Graph              *graph;
+  const std::vector<Node *> *sources;
+  uint32_t                 first;
+  uint32_t                 stride;
+  uint64_t                 visited;
+};
+
+static void *
+QueryThread (void *data)
+{
+  Queries *queries = (Queries *) data;
+  TraversalContext context (*queries->graph);
+  queries->visited = 0;
+  for (uint32_t i = queries->first; i < queries->sources->size (); i += queries->stride)
+    {
+      queries->visited += context.BFS ((*queries->sources)[i]);
+    }
+  return 0;
+}
+
+// runs the queries on threads, each with its own context
+static uint64_t
+RunQueries (const Graph *graph, const std::vector<Node *> &sources, uint32_t threads)
+{
+  std::vector<Queries> queries (threads);
+  std::vector<pthread_t> ids (threads);
+  for (uint32_t i = 0; i < threads; ++i)
+    {
+      Queries q = { graph, &sources, i, threads, 0 };
+      queries[i] = q;
+      pthread_create (&ids[i], 0, &QueryThread, &queries[i]);
+    }
+  uint64_t visited = 0;
+  for (uint32_t i = 0; i < threads; ++i)
+    {
+      pthread_join (ids[i], 0);
+      visited += queries[i].visited;
+    }
+  return visited;
+}
+
+// counts the positions where list and the snapshot order disagree
+static size_t
+CountMismatches (NodeListItem *list, const GraphSnapshot &snapshot, const std::vector<uint32_t> &order)
+{
+  size_t mismatches = 0;
+  for (size_t i = 0; i < order.size (); ++i, list = list->GetNext ())
+    {
+      if (!list || list->GetData () != snapshot.GetNode (order[i]))
+        {
+          mismatches++;
+        }
+    }
+  return mismatches + GetListSize (list);
+}
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t nodeCount = argc > 1 ? atoi (argv[1]) : 1000000;
+  uint32_t degree = argc > 2 ? atoi (argv[2]) : 4;
+
+  srand (1);
+  printf ("nodes %u, edges %u\n", nodeCount, nodeCount * degree);
+  Graph *g = new Graph ();
+
+  double start = GetTime ();
+  std::vector<Node *> nodes (nodeCount);
+  for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+      nodes[i] = g->NewNode ();
+    }
+  Report ("new node", GetTime () - start, nodeCount);
+
+  // a chain through all nodes keeps them reachable, the rest is random
+  start = GetTime ();
+  for (uint32_t i = 0; i < nodeCount; ++i)
+    {
+      if (i + 1 < nodeCount)
+        {
+          g->NewEdge (nodes[i], nodes[i + 1]);
+        }
+      for (uint32_t j = 1; j < degree; ++j)
+        {
+          g->NewEdge (nodes[i], nodes[rand () % nodeCount]);
+        }
+    }
+  Report ("new edge", GetTime () - start, g->GetEdgeCount ());
+
+  // each loop sums ids so that the work cannot be dropped
+  uint64_t sum = 0;
+  start = GetTime ();
+  for (Node *node = g->GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      sum += node->GetId ();
+    }
+  Report ("node iteration", GetTime () - start, g->GetNodeCount ());
+
+  start = GetTime ();
+  for (Edge *edge = g->GetFirstEdge (); edge; edge = edge->GetNextEdge ())
+    {
+      sum += edge->GetSucc ()->GetId ();
+    }
+  Report ("edge iteration", GetTime () - start, g->GetEdgeCount ());
+
+  start = GetTime ();
+  for (Node *node = g->GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      for (Edge *edge = node->GetFirstSucc (); edge; edge = edge->GetNextSucc ())
+        {
+          sum += edge->GetSucc ()->GetId ();
+        }
+    }
+  Report ("successors", GetTime () - start, g->GetEdgeCount ());
+
+  Numeration num = g->NewNum ();
+  start = GetTime ();
+  NodeListItem *list = g->DFS (num);
+  Report ("dfs", GetTime () - start, g->GetNodeCount ());
+  sum += GetListSize (list);
+  DeleteList (list);
+  g->FreeNum (num);
+
+  num = g->NewNum ();
+  start = GetTime ();
+  list = g->BFS (num);
+  Report ("bfs", GetTime () - start, g->GetNodeCount ());
+  sum += GetListSize (list);
+  DeleteList (list);
+  g->FreeNum (num);
+
+  start = GetTime ();
+  GraphSnapshot snapshot (*g);
+  Report ("snapshot", GetTime () - start, g->GetNodeCount () + g->GetEdgeCount ());
+
+  const std::vector<uint32_t> &offsets = snapshot.GetOffsets (GRAPH_DIR_DOWN);
+  const std::vector<uint32_t> &targets = snapshot.GetTargets (GRAPH_DIR_DOWN);
+  start = GetTime ();
+  for (uint32_t i = 0; i < snapshot.GetNodeCount (); ++i)
+    {
+      for (uint32_t j = offsets[i]; j < offsets[i + 1]; ++j)
+        {
+          sum += targets[j];
+        }
+    }
+  Report ("csr successors", GetTime () - start, snapshot.GetEdgeCount ());
+
+  std::vector<uint32_t> order;
+  start = GetTime ();
+  snapshot.DFS (order);
+  Report ("csr dfs", GetTime () - start, snapshot.GetNodeCount ());
+  num = g->NewNum ();
+  list = g->DFS (num);
+  size_t mismatches = CountMismatches (list, snapshot, order);
+  DeleteList (list);
+  g->FreeNum (num);
+
+  start = GetTime ();
+  snapshot.BFS (order);
+  Report ("csr bfs", GetTime () - start, snapshot.GetNodeCount ());
+  num = g->NewNum ();
+  list = g->BFS (num);
+  mismatches += CountMismatches (list, snapshot, order);
+  DeleteList (list);
+  g->FreeNum (num);
+
+  start = GetTime ();
+  Marker marker = g->NewMarker ();
+  for (Node *node = g->GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      node->Mark (marker);
+    }
+  Report ("mark", GetTime () - start, g->GetNodeCount ());
+
+  start = GetTime ();
+  for (Node *node = g->GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      sum += node->IsMarked (marker);
+    }
+  Report ("is marked", GetTime () - start, g->GetNodeCount ());
+  g->FreeMarker (marker);
+
+  // markers are cheap to acquire, the objects are never cleaned here
+  const uint32_t markers = 1000000;
+  start = GetTime ();
+  for (uint32_t i = 0; i < markers; ++i)
+    {
+      g->FreeMarker (g->NewMarker ());
+    }
+  Report ("new/free marker", GetTime () - start, markers);
+
+  // concurrent queries on the same graph
+  const uint32_t queryCount = 16;
+  uint32_t threads = std::max (1L, sysconf (_SC_NPROCESSORS_ONLN));
+  std::vector<Node *> sources;
+  for (uint32_t i = 0; i < queryCount; ++i)
+    {
+      sources.push_back (nodes[rand () % nodeCount]);
+    }
+  start = GetTime ();
+  uint64_t serial = RunQueries (g, sources, 1);
+  Report ("bfs queries", GetTime () - start, serial);
+  start = GetTime ();
+  uint64_t parallel = RunQueries (g, sources, threads);
+  Report ("parallel queries", GetTime () - start, parallel);
+  mismatches += serial != parallel;
+
+  // depths of the parallel search against the traversal context
+  TraversalContext context (*g);
+  ParallelBfs bfs (snapshot);
+  std::vector<uint32_t> depth;
+  double contextTime = 0;
+  double bfsTime = 0;
+  uint64_t reached = 0;
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      start = GetTime ();
+      context.BFS (sources[i]);
+      contextTime += GetTime () - start;
+
+      start = GetTime ();
+      reached += bfs.Run (snapshot.GetIndex (sources[i]), depth);
+      bfsTime += GetTime () - start;
+
+      for (uint32_t j = 0; j < snapshot.GetNodeCount (); ++j)
+        {
+          GraphNum expected = context.GetDepth (snapshot.GetNode (j));
+          mismatches += depth[j] != (expected == NUMBER_NO_NUM ? GRAPH_MAX_NODE_NUM : expected);
+        }
+    }
+  Report ("context bfs", contextTime, reached);
+  Report ("parallel bfs", bfsTime, reached);
+  printf ("%-16s %9u levels\n", "bottom-up", bfs.GetBottomUpLevels ());
+
+  MarkerTable table (*g);
+  start = GetTime ();
+  SideMarker sideMarker = table.NewMarker ();
+  for (Node *node = g->GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      sideMarker.Mark (node);
+    }
+  Report ("side mark", GetTime () - start, g->GetNodeCount ());
+
+  start = GetTime ();
+  for (Node *node = g->GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      sum += sideMarker.IsMarked (node);
+    }
+  Report ("side is marked", GetTime () - start, g->GetNodeCount ());
+  table.FreeMarker (sideMarker);
+
+  // more markers in use than the objects can hold
+  std::vector<SideMarker> inUse;
+  for (uint32_t i = 0; i < 4 * MAX_GRAPH_MARKERS; ++i)
+    {
+      inUse.push_back (table.NewMarker ());
+    }
+  start = GetTime ();
+  for (uint32_t i = 0; i < markers; ++i)
+    {
+      table.FreeMarker (table.NewMarker ());
+    }
+  Report ("new/free side", GetTime () - start, markers);
+  for (uint32_t i = 0; i < inUse.size (); ++i)
+    {
+      table.FreeMarker (inUse[i]);
+    }
+
+  char xmlName[] = "/tmp/graph-bench-XXXXXX";
+  char binaryName[] = "/tmp/graph-bench-XXXXXX";
+  close (mkstemp (xmlName));
+  close (mkstemp (binaryName));
+  start = GetTime ();
+  g->WriteToXml (xmlName);
+  Report ("xml write", GetTime () - start, g->GetNodeCount () + g->GetEdgeCount ());
+  start = GetTime ();
+  g->WriteToBinary (binaryName);
+  Report ("binary write", GetTime () - start, g->GetNodeCount () + g->GetEdgeCount ());
+
+  Graph *loaded = new Graph ();
+  start = GetTime ();
+  loaded->ReadFromXml (xmlName);
+  Report ("xml read", GetTime () - start, loaded->GetNodeCount () + loaded->GetEdgeCount ());
+  mismatches += loaded->GetNodeCount () != g->GetNodeCount () || loaded->GetEdgeCount () != g->GetEdgeCount ();
+  delete loaded;
+
+  loaded = new Graph ();
+  start = GetTime ();
+  loaded->ReadFromBinary (binaryName);
+  Report ("binary read", GetTime () - start, loaded->GetNodeCount () + loaded->GetEdgeCount ());
+  mismatches += loaded->GetNodeCount () != g->GetNodeCount () || loaded->GetEdgeCount () != g->GetEdgeCount ();
+  for (Node *node = g->GetFirstNode (), *other = loaded->GetFirstNode ();
+       node && other; node = node->GetNextNode (), other = other->GetNextNode ())
+    {
+      mismatches += node->GetUserId () != other->GetUserId ();
+    }
+  delete loaded;
+  unlink (xmlName);
+  unlink (binaryName);
+
+  start = GetTime ();
+  delete g;
+  Report ("destruction", GetTime () - start, nodeCount + nodeCount * degree);
+
+  printf ("checksum %llu, mismatches %lu\n", (unsigned long long) sum, (unsigned long) mismatches);
+  return mismatches != 0;
+}
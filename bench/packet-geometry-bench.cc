@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+/*
+ * Times the whole per-frame update of the packets in flight while a trace
+ * plays: the per-packet loop NamNetMotion used first, a geometry rebuilt and
+ * sorted by colour every frame, and the persistent per-colour geometry which
+ * only appends admitted packets and compacts received ones.
+ *
+ * usage: packet-geometry-bench [packets in flight] [frames]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <sys/time.h>
+
+#include "common.h"
+#include "nam-packet-geometry.h"
+
+static const uint32_t COLORS = 10;
+static const uint32_t LINKS = 1000;
+static const double STEP = 1E-3;
+
+static double
+GetTime (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+static double
+Random (double from, double to)
+{
+  return from + (to - from) * rand () / RAND_MAX;
+}
+
+struct Hop
+{
+  double x;
+  double y;
+  double dx;
+  double dy;
+};
+
+// the branchy per-packet arithmetic of NamNetMotion::GetPacketSegment
+static bool
+GetSegment (const Packet &pkt, const Hop &hop, double time, Point &from, Point &to)
+{
+  if (pkt.GetLastBitRx () <= time || pkt.GetFirstBitTx () > time)
+    {
+      return false;
+    }
+
+  double txTime = pkt.GetLastBitTx () - pkt.GetFirstBitTx ();
+  if (pkt.GetLastBitTx () > time) txTime = time - pkt.GetFirstBitTx ();
+  if (pkt.GetFirstBitRx () < time) txTime -= time - pkt.GetFirstBitRx ();
+  double delay = pkt.GetFirstBitRx () - pkt.GetFirstBitTx ();
+  double lbTime = time - pkt.GetLastBitTx ();
+  if (lbTime < 0) lbTime = 0;
+  double pktDist = lbTime / delay;
+  double pktEnd = pktDist + txTime / delay;
+
+  from = Point (hop.x + hop.dx * pktDist, hop.y + hop.dy * pktDist);
+  to = Point (hop.x + hop.dx * pktEnd, hop.y + hop.dy * pktEnd);
+  return true;
+}
+
+// packets of the trace in flight, in trace order
+class Buffer
+{
+public:
+  Buffer (const std::vector<Packet> &trace) : m_trace (trace), m_next (0) {}
+
+  // drops received packets and appends admitted ones
+  void Update (double time)
+  {
+    std::vector<uint32_t>::iterator last = m_ids.begin ();
+    for (std::vector<uint32_t>::const_iterator i = m_ids.begin (); i != m_ids.end (); ++i)
+      {
+        if (m_trace[*i].GetLastBitRx () > time)
+          {
+            *last++ = *i;
+          }
+      }
+    m_ids.erase (last, m_ids.end ());
+    for (; m_next < m_trace.size () && m_trace[m_next].GetFirstBitTx () <= time; ++m_next)
+      {
+        if (m_trace[m_next].GetLastBitRx () > time)
+          {
+            m_ids.push_back (m_next);
+          }
+      }
+  }
+
+  std::vector<uint32_t> m_ids;
+
+private:
+  const std::vector<Packet> &m_trace;
+  uint32_t m_next;
+};
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t active = argc > 1 ? atoi (argv[1]) : 100000;
+  uint32_t frames = argc > 2 ? atoi (argv[2]) : 200;
+
+  // packets live 0.011 to 0.12 s, admit them at the rate which keeps
+  // the requested number in flight once the first ones are received
+  double warmup = 0.2;
+  double length = warmup + frames * STEP + 0.2;
+  uint32_t count = (uint32_t)(active / 0.0655 * length);
+
+  srand (1);
+  std::vector<Hop> hops (LINKS);
+  for (uint32_t i = 0; i < LINKS; ++i)
+    {
+      hops[i].x = Random (0, 100);
+      hops[i].y = Random (0, 100);
+      hops[i].dx = Random (-10, 10);
+      hops[i].dy = Random (-10, 10);
+    }
+  std::vector<Packet> trace;
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      double fbTx = length * i / count;
+      double lbTx = fbTx + Random (0.001, 0.01);
+      double fbRx = fbTx + Random (0.01, 0.1);
+      double lbRx = fbRx + (lbTx - fbTx);
+      trace.push_back (Packet (rand () % LINKS, rand () % 2, fbTx, lbTx, fbRx, lbRx));
+    }
+
+  // each path sums a coordinate so that the work cannot be dropped
+  double sum = 0;
+  Buffer loopBuffer (trace);
+  loopBuffer.Update (warmup);
+  double start = GetTime ();
+  for (uint32_t f = 1; f <= frames; ++f)
+    {
+      double time = warmup + f * STEP;
+      loopBuffer.Update (time);
+      for (std::vector<uint32_t>::const_iterator i = loopBuffer.m_ids.begin (); i != loopBuffer.m_ids.end (); ++i)
+        {
+          Point from, to;
+          if (GetSegment (trace[*i], hops[trace[*i].GetLink ()], time, from, to))
+            {
+              sum += from.x;
+            }
+        }
+    }
+  double loop = GetTime () - start;
+
+  double rsum = 0;
+  Buffer rebuildBuffer (trace);
+  rebuildBuffer.Update (warmup);
+  PacketGeometry rebuilt;
+  std::vector<uint32_t> sorted;
+  start = GetTime ();
+  for (uint32_t f = 1; f <= frames; ++f)
+    {
+      double time = warmup + f * STEP;
+      rebuildBuffer.Update (time);
+      // counting sort by colour, then every array is refilled
+      const std::vector<uint32_t> &ids = rebuildBuffer.m_ids;
+      std::vector<uint32_t> offsets (COLORS + 1, 0);
+      for (std::vector<uint32_t>::const_iterator i = ids.begin (); i != ids.end (); ++i)
+        {
+          offsets[trace[*i].GetSeries () % COLORS + 1]++;
+        }
+      for (uint32_t c = 1; c <= COLORS; ++c)
+        {
+          offsets[c] += offsets[c - 1];
+        }
+      sorted.resize (ids.size ());
+      for (std::vector<uint32_t>::const_iterator i = ids.begin (); i != ids.end (); ++i)
+        {
+          sorted[offsets[trace[*i].GetSeries () % COLORS]++] = *i;
+        }
+      rebuilt.Clear ();
+      for (std::vector<uint32_t>::const_iterator i = sorted.begin (); i != sorted.end (); ++i)
+        {
+          const Hop &hop = hops[trace[*i].GetLink ()];
+          rebuilt.Add (trace[*i], hop.x, hop.y, hop.dx, hop.dy, *i);
+        }
+      rebuilt.Compute (time);
+      for (uint32_t i = 0; i < rebuilt.GetSize (); ++i)
+        {
+          if (rebuilt.visible[i])
+            {
+              rsum += rebuilt.x1[i];
+            }
+        }
+    }
+  double rebuild = GetTime () - start;
+
+  // the persistent geometry is filled like NamNetMotion::UpdateBuffer does
+  double psum = 0;
+  std::vector<PacketGeometry> geometry (COLORS);
+  uint32_t next = 0;
+  double time = warmup;
+  start = 0;
+  for (uint32_t f = 0; f <= frames; ++f)
+    {
+      time = warmup + f * STEP;
+      if (f == 1)
+        {
+          start = GetTime ();
+        }
+      for (uint32_t c = 0; c < COLORS; ++c)
+        {
+          geometry[c].RemoveReceived (time);
+        }
+      for (; next < trace.size () && trace[next].GetFirstBitTx () <= time; ++next)
+        {
+          if (trace[next].GetLastBitRx () > time)
+            {
+              const Hop &hop = hops[trace[next].GetLink ()];
+              geometry[trace[next].GetSeries () % COLORS].Add (trace[next], hop.x, hop.y, hop.dx, hop.dy, next);
+            }
+        }
+      for (uint32_t c = 0; c < COLORS; ++c)
+        {
+          PacketGeometry &g = geometry[c];
+          g.Compute (time);
+          for (uint32_t i = 0; i < g.GetSize (); ++i)
+            {
+              if (g.visible[i] && f > 0)
+                {
+                  psum += g.x1[i];
+                }
+            }
+        }
+    }
+  double persistent = GetTime () - start;
+
+  // compare the persistent geometry of the last frame against the loop
+  double error = 0;
+  uint32_t mismatches = 0, size = 0;
+  for (uint32_t c = 0; c < COLORS; ++c)
+    {
+      const PacketGeometry &g = geometry[c];
+      size += g.GetSize ();
+      for (uint32_t i = 0; i < g.GetSize (); ++i)
+        {
+          Point from, to;
+          const Packet &packet = trace[g.id[i]];
+          bool visible = GetSegment (packet, hops[packet.GetLink ()], time, from, to);
+          if (visible != (g.visible[i] != 0) || packet.GetSeries () % COLORS != c || (i > 0 && g.id[i - 1] >= g.id[i]))
+            {
+              mismatches++;
+            }
+          else if (visible)
+            {
+              error = std::max (error, std::fabs (from.x - g.x1[i]) + std::fabs (from.y - g.y1[i]) +
+                                       std::fabs (to.x - g.x2[i]) + std::fabs (to.y - g.y2[i]));
+            }
+        }
+    }
+  mismatches += size != loopBuffer.m_ids.size ();
+
+  printf ("packets %u in flight, frames %u, kernel %s\n", size, frames, PacketGeometry::GetKernelName ());
+  printf ("loop       %8.3f ms/frame\n", loop * 1000 / frames);
+  printf ("rebuild    %8.3f ms/frame (%.2fx)\n", rebuild * 1000 / frames, loop / rebuild);
+  printf ("persistent %8.3f ms/frame (%.2fx)\n", persistent * 1000 / frames, loop / persistent);
+  printf ("mismatches %u, max error %g, checksum differences %g %g\n", mismatches, error,
+          std::fabs (sum - rsum), std::fabs (sum - psum));
+  return mismatches != 0;
+}
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+/*
+ * Compares frames rasterized in tiles by TileRenderer with frames drawn
+ * by a single context, pixel by pixel, and measures both. RGB24 frames on
+ * white are drawn like Scene does on the GTK thread, transparent ARGB32
+ * frames like the render thread does.
+ *
+ * usage: tile-bench [trace] [width height] [frames]
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/time.h>
+#include <gtkmm.h>
+
+#include "algorithm.h"
+#include "nam-net-motion.h"
+#include "tile-renderer.h"
+
+static double
+GetTime (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1E-6;
+}
+
+static void
+DrawTile (const Cairo::RefPtr<Cairo::Context> &context, NamNetMotion *motion, Cairo::Matrix matrix, bool opaque)
+{
+  if (opaque)
+    {
+      context->set_source_rgba (1.0, 1.0, 1.0, 1);
+      context->paint ();
+    }
+  context->set_matrix (matrix);
+  motion->DrawFrame (context);
+}
+
+static void
+DrawFrame (const Cairo::RefPtr<Cairo::ImageSurface> &surface, NamNetMotion *motion, const Cairo::Matrix &matrix, bool opaque)
+{
+  Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (surface);
+  context->set_operator (Cairo::OPERATOR_CLEAR);
+  context->paint ();
+  context->set_operator (Cairo::OPERATOR_OVER);
+  DrawTile (context, motion, matrix, opaque);
+  surface->flush ();
+}
+
+static uint32_t
+CountMismatches (const Cairo::RefPtr<Cairo::ImageSurface> &s1, const Cairo::RefPtr<Cairo::ImageSurface> &s2)
+{
+  uint32_t mismatches = 0;
+  int bytes = s1->get_width () * 4;
+  for (int y = 0; y < s1->get_height (); ++y)
+    {
+      const unsigned char *row1 = s1->get_data () + y * s1->get_stride ();
+      const unsigned char *row2 = s2->get_data () + y * s2->get_stride ();
+      for (int x = 0; x < bytes; x += 4)
+        {
+          // RGB24 leaves the unused byte undefined
+          bool opaque = s1->get_format () == Cairo::FORMAT_RGB24;
+          uint32_t p1, p2;
+          memcpy (&p1, row1 + x, 4);
+          memcpy (&p2, row2 + x, 4);
+          if (opaque ? (p1 & 0xffffff) != (p2 & 0xffffff) : p1 != p2)
+            {
+              mismatches++;
+            }
+        }
+    }
+  return mismatches;
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string filename = argc > 1 ? argv[1] : "demo.nam";
+  int width = argc > 3 ? atoi (argv[2]) : 2560;
+  int height = argc > 3 ? atoi (argv[3]) : 1440;
+  uint32_t frames = argc > 4 ? atoi (argv[4]) : 50;
+
+  Glib::thread_init ();
+  Gio::init ();
+
+  Glib::RefPtr<NamNetMotion> motion = NamNetMotion::Create ();
+  Glib::RefPtr<Gio::File> file = Gio::File::create_for_path (filename);
+  motion->LoadMotion (Gio::DataInputStream::create (file->read ()));
+  motion->SetMotionSpeed (motion->GetLastTime () / 2 / frames);
+
+  // fit the topology into the frame, as the exporter does
+  double zoom;
+  Point center;
+  algorithm::Scale (Rectangle (0, 0, width, height), motion->GetNodes (), motion->GetNodeWidth (), zoom, center);
+  Cairo::Matrix matrix;
+  cairo_matrix_init_translate (&matrix, width / 2.0, height / 2.0);
+  cairo_matrix_scale (&matrix, zoom, zoom);
+  cairo_matrix_translate (&matrix, -center.x, -center.y);
+
+  TileRenderer tiles;
+  tiles.SetThreads (std::max (2L, sysconf (_SC_NPROCESSORS_ONLN)));
+
+  uint32_t mismatches = 0;
+  for (int opaque = 1; opaque >= 0; --opaque)
+    {
+      Cairo::Format format = opaque ? Cairo::FORMAT_RGB24 : Cairo::FORMAT_ARGB32;
+      Cairo::RefPtr<Cairo::ImageSurface> single = Cairo::ImageSurface::create (format, width, height);
+      Cairo::RefPtr<Cairo::ImageSurface> tiled = Cairo::ImageSurface::create (format, width, height);
+      TileRenderer::DrawSlot draw = sigc::bind (sigc::ptr_fun (&DrawTile), motion.operator-> (), matrix, opaque != 0);
+
+      double singleTime = 0, tiledTime = 0;
+      motion->Seek (0);
+      for (uint32_t f = 0; f < frames; ++f)
+        {
+          motion->EnterFrame (1);
+
+          double start = GetTime ();
+          DrawFrame (single, motion.operator-> (), matrix, opaque);
+          singleTime += GetTime () - start;
+
+          start = GetTime ();
+          Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (tiled);
+          context->set_operator (Cairo::OPERATOR_CLEAR);
+          context->paint ();
+          tiles.Render (tiled, 0, draw);
+          tiledTime += GetTime () - start;
+
+          mismatches += CountMismatches (single, tiled);
+        }
+
+      printf ("%-6s single %8.3f ms/frame, tiled %8.3f ms/frame (%u threads)\n", opaque ? "rgb24" : "argb32",
+              singleTime * 1000 / frames, tiledTime * 1000 / frames, tiles.GetThreads ());
+    }
+
+  printf ("%dx%d, %u frames, pixel mismatches %u\n", width, height, frames, mismatches);
+  return mismatches != 0;
+}
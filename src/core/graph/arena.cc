@@ -0,0 +1,167 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <new>
+#include "arena.h"
+
+namespace graph {
+
+Arena::Arena ()
+  : m_next (0),
+    m_end (0),
+    m_free (MAX_CLASS_SIZE / ALIGNMENT + 1, (void *) 0)
+{
+}
+
+Arena::~Arena ()
+{
+  for (std::vector<char *>::const_iterator i = m_slabs.begin (); i != m_slabs.end (); ++i)
+    {
+      ::operator delete (*i);
+    }
+  for (std::set<void *>::const_iterator i = m_large.begin (); i != m_large.end (); ++i)
+    {
+      ::operator delete (*i);
+    }
+}
+
+void *
+Arena::Allocate (size_t size)
+{
+  size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  if (size > MAX_CLASS_SIZE)
+    {
+      void *p = ::operator new (size);
+      try
+        {
+          m_large.insert (p);
+        }
+      catch (...)
+        {
+          ::operator delete (p);
+          throw;
+        }
+      return p;
+    }
+
+  void *&head = m_free[size / ALIGNMENT];
+  if (head)
+    {
+      void *p = head;
+      head = *(void **) p;
+      return p;
+    }
+
+  if (m_end - m_next < (ptrdiff_t) size)
+    {
+      // the rest of the slab is lost, at most MAX_CLASS_SIZE bytes
+      m_next = (char *) ::operator new (SLAB_SIZE);
+      m_end = m_next + SLAB_SIZE;
+      m_slabs.push_back (m_next);
+    }
+
+  void *p = m_next;
+  m_next += size;
+  return p;
+}
+
+void
+Arena::Free (void *p, size_t size)
+{
+  size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  if (size > MAX_CLASS_SIZE)
+    {
+      m_large.erase (p);
+      ::operator delete (p);
+      return;
+    }
+
+  void *&head = m_free[size / ALIGNMENT];
+  *(void **) p = head;
+  head = p;
+}
+
+size_t
+Arena::GetReservedSize (void) const
+{
+  return m_slabs.size () * SLAB_SIZE;
+}
+
+//// ArenaObject
+
+ArenaObject::Header *
+ArenaObject::GetHeader (const void *p)
+{
+  return (Header *) ((char *) p - HEADER_SIZE);
+}
+
+void *
+ArenaObject::operator new (size_t size)
+{
+  char *p = (char *) ::operator new (HEADER_SIZE + size);
+  Header *header = (Header *) p;
+  header->arena = 0;
+  header->size = HEADER_SIZE + size;
+  return p + HEADER_SIZE;
+}
+
+void *
+ArenaObject::operator new (size_t size, Arena *arena)
+{
+  char *p = (char *) arena->Allocate (HEADER_SIZE + size);
+  Header *header = (Header *) p;
+  header->arena = arena;
+  header->size = HEADER_SIZE + size;
+  return p + HEADER_SIZE;
+}
+
+void
+ArenaObject::operator delete (void *p)
+{
+  if (!p)
+    {
+      return;
+    }
+
+  Header *header = GetHeader (p);
+  if (header->arena)
+    {
+      header->arena->Free (header, header->size);
+    }
+  else
+    {
+      ::operator delete (header);
+    }
+}
+
+void
+ArenaObject::operator delete (void *p, Arena *)
+{
+  // only called when a constructor throws in new (arena)
+  operator delete (p);
+}
+
+bool
+ArenaObject::IsAllocatedIn (const void *p, const Arena *arena)
+{
+  return GetHeader (p)->arena == arena;
+}
+
+} // namespace graph
@@ -0,0 +1,114 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <set>
+#include <vector>
+
+namespace graph {
+
+/**
+ * \brief Slab allocator of small objects
+ *
+ * Memory is cut from large slabs and returned to free lists of its size
+ * class, larger blocks come from the system and are recorded. All slabs
+ * and the blocks not freed yet are released when the arena is destroyed.
+ * Not thread safe.
+ */
+class Arena
+{
+public:
+  Arena ();
+  /**
+   * \brief release all memory, without calling any destructor
+   */
+  ~Arena ();
+
+  /**
+   * \returns memory for size bytes aligned to ALIGNMENT
+   */
+  void *Allocate (size_t size);
+  /**
+   * \brief return memory got from Allocate with the same size
+   */
+  void Free (void *p, size_t size);
+  /**
+   * \returns bytes taken from the system
+   */
+  size_t GetReservedSize (void) const;
+
+  static const size_t ALIGNMENT = 16;
+
+private:
+  Arena (const Arena &);
+  Arena &operator = (const Arena &);
+
+  static const size_t SLAB_SIZE = 1 << 20;
+  static const size_t MAX_CLASS_SIZE = 1024; // larger blocks come from the system
+
+  std::vector<char *> m_slabs;
+  char                *m_next; // free space of the last slab
+  char                *m_end;
+  std::vector<void *> m_free; // free list of every size class
+  std::set<void *>    m_large; // blocks larger than MAX_CLASS_SIZE
+};
+
+/**
+ * \brief Base of objects which may be allocated in an Arena
+ *
+ * Objects created with new (arena) live in the arena, objects created
+ * with plain new on the heap. Both are freed with delete, and objects in
+ * an arena may also be destroyed by calling their destructor and let the
+ * arena release their memory.
+ */
+class ArenaObject
+{
+public:
+  static void *operator new (size_t size);
+  static void *operator new (size_t size, Arena *arena);
+  static void operator delete (void *p);
+  static void operator delete (void *p, Arena *arena);
+
+  /**
+   * \param p complete object, e.g. dynamic_cast<void *> (object)
+   * \returns true if object has been created with new (arena)
+   */
+  static bool IsAllocatedIn (const void *p, const Arena *arena);
+
+private:
+  /**
+   * \brief precedes every object and keeps it aligned
+   */
+  struct Header
+  {
+    Arena  *arena;
+    size_t size;
+  };
+  static const size_t HEADER_SIZE = (sizeof (Header) + Arena::ALIGNMENT - 1) / Arena::ALIGNMENT * Arena::ALIGNMENT;
+
+  static Header *GetHeader (const void *p);
+};
+
+} // namespace graph
+
+#endif /* ARENA_H */
@@ -0,0 +1,125 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <cstring>
+#include "binary.h"
+#include "graph-common.h"
+
+namespace graph {
+
+void
+BinaryWriter::WriteUint32 (uint32_t value)
+{
+  Write (&value, sizeof (value));
+}
+
+void
+BinaryWriter::WriteUint64 (uint64_t value)
+{
+  Write (&value, sizeof (value));
+}
+
+void
+BinaryWriter::WriteDouble (double value)
+{
+  Write (&value, sizeof (value));
+}
+
+void
+BinaryWriter::WriteString (const std::string &value)
+{
+  WriteUint32 (value.size ());
+  Write (value.data (), value.size ());
+}
+
+void
+BinaryWriter::Write (const void *data, size_t size)
+{
+  const char *bytes = (const char *) data;
+  m_buffer.insert (m_buffer.end (), bytes, bytes + size);
+}
+
+void
+BinaryWriter::Clear (void)
+{
+  m_buffer.clear ();
+}
+
+//// BinaryReader
+
+BinaryReader::BinaryReader (const char *data, size_t size)
+  : m_next (data),
+    m_end (data + size)
+{
+}
+
+uint32_t
+BinaryReader::ReadUint32 (void)
+{
+  uint32_t value;
+  Read (&value, sizeof (value));
+  return value;
+}
+
+uint64_t
+BinaryReader::ReadUint64 (void)
+{
+  uint64_t value;
+  Read (&value, sizeof (value));
+  return value;
+}
+
+double
+BinaryReader::ReadDouble (void)
+{
+  double value;
+  Read (&value, sizeof (value));
+  return value;
+}
+
+std::string
+BinaryReader::ReadString (void)
+{
+  uint32_t size = ReadUint32 ();
+  GraphAssert<GraphErrorType> (size <= GetRemaining (), GRAPH_ERROR_BINARY_READ);
+  std::string value (m_next, size);
+  m_next += size;
+  return value;
+}
+
+void
+BinaryReader::Read (void *data, size_t size)
+{
+  GraphAssert<GraphErrorType> (size <= GetRemaining (), GRAPH_ERROR_BINARY_READ);
+  // the data of a mapped file is not aligned
+  memcpy (data, m_next, size);
+  m_next += size;
+}
+
+BinaryReader
+BinaryReader::ReadBlock (size_t size)
+{
+  GraphAssert<GraphErrorType> (size <= GetRemaining (), GRAPH_ERROR_BINARY_READ);
+  BinaryReader block (m_next, size);
+  m_next += size;
+  return block;
+}
+
+} // namespace graph
@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace graph {
+
+/**
+ * \brief Buffer of values in the binary graph format
+ *
+ * Values are stored in the byte order of the machine, files record it
+ * in their header.
+ */
+class BinaryWriter
+{
+public:
+  void WriteUint32 (uint32_t value);
+  void WriteUint64 (uint64_t value);
+  void WriteDouble (double value);
+  /**
+   * \brief write length of string and its bytes
+   */
+  void WriteString (const std::string &value);
+  void Write (const void *data, size_t size);
+
+  inline const char *GetData (void) const
+  {
+    return m_buffer.empty () ? 0 : &m_buffer[0];
+  }
+  inline size_t GetSize (void) const
+  {
+    return m_buffer.size ();
+  }
+  void Clear (void);
+
+private:
+  std::vector<char> m_buffer;
+};
+
+/**
+ * \brief Reads values written by BinaryWriter from memory
+ *
+ * Reading past the end throws GRAPH_ERROR_BINARY_READ.
+ */
+class BinaryReader
+{
+public:
+  BinaryReader (const char *data, size_t size);
+
+  uint32_t ReadUint32 (void);
+  uint64_t ReadUint64 (void);
+  double ReadDouble (void);
+  std::string ReadString (void);
+  void Read (void *data, size_t size);
+  /**
+   * \returns reader of the next size bytes, which are skipped by this one
+   */
+  BinaryReader ReadBlock (size_t size);
+
+  inline size_t GetRemaining (void) const
+  {
+    return m_end - m_next;
+  }
+
+private:
+  const char *m_next;
+  const char *m_end;
+};
+
+} // namespace graph
+
+#endif /* BINARY_H */
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <iostream>
+#include "node.h"
+#include "edge.h"
+#include "xml-util.h"
+
+namespace graph {
+
+Edge::Edge (Graph *graph, GraphNum id, Node *pred, Node *succ)
+  : m_id (id),
+    m_userId (id),
+    m_graph (graph),
+    m_graphItem (this)
+{
+  for (uint32_t dir = 0; dir < GRAPH_DIRS_NUM; ++dir)
+    {
+      m_nodes[dir] = 0;
+      m_nodeItems[dir].SetData (this);
+    }
+  SetPred (pred);
+  SetSucc (succ);
+}
+
+Edge::~Edge ()
+{
+}
+
+void
+Edge::SetNode (Node *node, GraphDir dir)
+{
+  GraphAssert<GraphErrorType> (node && node->GetGraph () == m_graph, GRAPH_ERROR_FOREIGN_OBJECT);
+  if (m_nodes[dir])
+    {
+      DetachFromNode (dir);
+    }
+  m_nodes[dir] = node;
+  node->AddEdgeInDir (this, RevDir (dir));
+}
+
+void
+Edge::SetPred (Node *node)
+{
+  SetNode (node, GRAPH_DIR_UP);
+}
+
+void
+Edge::SetSucc (Node *node)
+{
+  SetNode (node, GRAPH_DIR_DOWN);
+}
+
+void
+Edge::DetachFromNode (GraphDir dir)
+{
+  m_nodes[dir]->DeleteEdgeInDir (this, RevDir (dir));
+  m_nodes[dir] = 0;
+}
+
+void
+Edge::DebugPrint (void) const
+{
+  std::cout << "  n" << GetPred ()->GetId () << " -> n" << GetSucc ()->GetId () << ";" << std::endl;
+}
+
+void
+Edge::WriteByXmlWriter (xmlTextWriterPtr writer)
+{
+  xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "user", "%u", m_userId);
+}
+
+void
+Edge::ReadByXml (xmlNode *node)
+{
+  GetXmlProp (node, "user", m_userId);
+}
+
+void
+Edge::WriteByBinaryWriter (BinaryWriter &writer)
+{
+  writer.WriteUint32 (m_userId);
+}
+
+void
+Edge::ReadByBinary (BinaryReader &reader)
+{
+  m_userId = reader.ReadUint32 ();
+}
+
+} // namespace graph
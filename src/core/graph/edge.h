@@ -21,211 +21,191 @@
 #ifndef EDGE_H
 #define EDGE_H
 
-#include <vector>
-#include <stdlib.h>
-
-class Edge: public Marked, public Numbered
+#include <libxml/tree.h>
+#include <libxml/xmlwriter.h>
+#include "arena.h"
+#include "binary.h"
+#include "graph-common.h"
+#include "marker.h"
+#include "numeration.h"
+
+namespace graph {
+
+/**
+ * \brief Edge representation class.
+ */
+class Edge: public Marked, public Numbered, public ArenaObject
 {
-  int user_id;
+public:
+  virtual ~Edge ();
+
+  /**
+   * \returns unique id given by the graph
+   */
+  inline GraphNum GetId (void) const;
+  inline uint32_t GetUserId (void) const;
+  inline void SetUserId (uint32_t id);
+  /**
+   * \brief get edge's corresponding graph
+   */
+  inline Graph *GetGraph (void) const;
+  /**
+   * \brief get node in specified direction
+   */
+  inline Node *GetNode (GraphDir dir) const;
+  /**
+   * \brief get predecessor of edge
+   */
+  inline Node *GetPred (void) const;
+  /**
+   * \brief get successor of edge
+   */
+  inline Node *GetSucc (void) const;
+  /**
+   * Connect edge to a node in specified direction.
+   * Note that node treats this edge in opposite direction. I.e. an edge that has node in
+   * GRAPH_DIR_UP is treated as edge in GRAPH_DIR_DOWN directions inside that node
+   */
+  void SetNode (Node *node, GraphDir dir);
+  /**
+   * \brief connect edge with given node as a predecessor
+   */
+  void SetPred (Node *node);
+  /**
+   * \brief connect edge with given node as a successor
+   */
+  void SetSucc (Node *node);
+  /**
+   * \returns next edge of a graph
+   */
+  inline Edge *GetNextEdge (void) const;
+  /**
+   * \returns next edge of the same node in given direction, i.e. the
+   * next successor of GetPred () for GRAPH_DIR_DOWN
+   */
+  inline Edge *GetNextEdgeInDir (GraphDir dir) const;
+  /**
+   * \returns next successor edge of the predecessor
+   */
+  inline Edge *GetNextSucc (void) const;
+  /**
+   * \returns next predecessor edge of the successor
+   */
+  inline Edge *GetNextPred (void) const;
+  /**
+   * Print edge in dot format to stdout
+   */
+  virtual void DebugPrint (void) const;
 
-  /** Graph part */
-  int unique_id; //Unique ID
+protected:
+  /**
+   * Constructors are made protected, only graph can create edges
+   */
+  Edge (Graph *graph, GraphNum id, Node *pred, Node *succ);
+  /**
+   * \brief write attributes and children of the edge element
+   */
+  virtual void WriteByXmlWriter (xmlTextWriterPtr writer);
+  /**
+   * \brief read attributes and children of the edge element
+   */
+  virtual void ReadByXml (xmlNode *node);
+  /**
+   * \brief write the record of the edge in the binary format
+   */
+  virtual void WriteByBinaryWriter (BinaryWriter &writer);
+  /**
+   * \brief read the record written by WriteByBinaryWriter
+   */
+  virtual void ReadByBinary (BinaryReader &reader);
 
-protected:    Graph * graph; //Graph
-        virtual void writeByXmlWriter( xmlTextWriterPtr writer);
-        virtual void readByXml (xmlNode * cur_node);
 private:
-    EdgeListItem graph_it; //Position in Graph's list of edges
+  /** Graph and Node have access to Edge's members */
+  friend class Graph;
+  friend class Node;
+
+  /**
+   * \brief detach edge from the node in specified direction
+   */
+  void DetachFromNode (GraphDir dir);
+
+  GraphNum     m_id; // unique id is given by graph and cannot be modified
+  uint32_t     m_userId;
+  Graph        *m_graph;
+  EdgeListItem m_graphItem; // item of graph's list
+  Node         *m_nodes[GRAPH_DIRS_NUM]; // adjacent nodes
+  EdgeListItem m_nodeItems[GRAPH_DIRS_NUM]; // item in the list of each adjacent node
+};
+
+GraphNum
+Edge::GetId (void) const
+{
+  return m_id;
+}
 
+uint32_t
+Edge::GetUserId (void) const
+{
+  return m_userId;
+}
 
-    /** Nodes */
-    Node *nodes[ GRAPH_DIRS_NUM]; //Adjacent nodes
-    EdgeListItem n_it[ GRAPH_DIRS_NUM];//Position in each node's list
+void
+Edge::SetUserId (uint32_t id)
+{
+  m_userId = id;
+}
 
-    /** Graph and Node have access to Edge's members */
-    friend class Graph;
-    friend class Node;
+Graph *
+Edge::GetGraph (void) const
+{
+  return m_graph;
+}
 
-        inline void detachFromGraph()
-    {
-        graph_it.detach();
-    }
-protected:
-    /** Constructors are made protected, only nodes and graph can create edges */
-    Edge( Graph *graph_p, int _id, Node *_pred, Node* _succ):
-                 unique_id( _id), graph( graph_p), graph_it()
-    {
-                nodes[GRAPH_DIR_DOWN] = 0;
-                nodes[GRAPH_DIR_UP] = 0;
-        graph_it.setData( (Edge*) this);
-        n_it[ GRAPH_DIR_UP] = EdgeListItem();
-        n_it[ GRAPH_DIR_DOWN] = EdgeListItem();
-        n_it[ GRAPH_DIR_UP].setData( (Edge*)this);
-        n_it[ GRAPH_DIR_DOWN].setData( (Edge*)this);
-        setPred( _pred);
-        setSucc( _succ);
-    }
-public:
-    /**
-     * get edge's unique ID
-     */
-    inline int id() const
-    {
-        return unique_id;
-    }
-
-    inline int userId() const
-    {
-        return user_id;
-    }
-    inline void setUserId( int i)
-    {
-        user_id = i;
-    }
-    /**
-     * get edge's corresponding graph
-     */
-    virtual inline Graph * getGraph() const
-    {
-        return graph;
-    }
-
-    /** Pivate routines dealing with iterators */
-    void setGraphIt( EdgeListItem g_it)
-    {
-        graph_it = g_it;
-    }
-    /**
-     * Return iterator pointing to this edge in graph's edge list
-     */
-    virtual EdgeListItem *getGraphIt()
-    {
-        return &graph_it;
-    }
-
-    /**
-     * set iterator pointing to this edge in graph's edge list
-     */
-    void setListIt( GraphDir dir, EdgeListItem it)
-    {
-        n_it[ dir] = it;
-    }
-
-    /**
-     * Return iterator pointing to this edge in node's edge
-     * list in corresponding direction
-     */
-    virtual EdgeListItem *getNodeIt( GraphDir dir)
-    {
-        return &n_it[ dir];
-    }
-
-    /**
-     * detach edge from a node.
-     * Made private as it is low-level routine needed for implementation of edge-node relationship
-     */
-    void detachFromNode( GraphDir dir);
-    /**
-     *  Destructor. delete edge from list in graph.
-     *  Deletion from node lists MUST be performed manually.
-     *  Example:
-     *      Graph graph;
-     *      Edge * edge = graph.newEdge();
-     *
-     *      //Typical deletion of edge is done by consequent calls of
-     *      edge->detachFromNode( GRAPH_DIR_UP);
-     *      edge->detachFromNode( GRAPH_DIR_DOWN);
-     *      delete edge;
-     */
-    virtual ~Edge();
-
-    /**
-     * Connect edge to a node in specified direction.
-     * Note that node treats this edge in opposite direction. I.e. an edge that has node in
-     * GRAPH_DIR_UP is treated as edge in GRAPH_DIR_DOWN directions inside that node
-     */
-    virtual void setNode( Node *n, GraphDir dir)
-    {
-        graphassert( isNotNullP( n));
-                if (nodes[ dir]) detachFromNode (dir);
-        nodes[ dir] = n;
-        if ( n != NULL)
-        {
-            n->addEdgeInDir( (Edge *)this,
-                ((dir == GRAPH_DIR_UP)? GRAPH_DIR_DOWN : GRAPH_DIR_UP));
-        }
-    }
-
-    /**
-     * Connect edge with given node as a predecessor
-     */
-    virtual inline void setPred( Node *n)
-    {
-        setNode( n, GRAPH_DIR_UP);
-    }
-    /**
-     * Connect edge with given node as a successor
-     */
-    virtual inline void setSucc( Node *n)
-    {
-        setNode( n, GRAPH_DIR_DOWN);
-    }
-
-    /**
-     * get node in specified direction
-     */
-    virtual inline Node *getNode( GraphDir dir) const
-    {
-        return nodes[ dir];
-    }
-    /**
-     * get predecessor of edge
-     */
-    virtual inline Node *pred() const
-    {
-        return getNode( GRAPH_DIR_UP);
-    }
-    /**
-     * get successor of edge
-     */
-    virtual inline Node *succ() const
-    {
-        return getNode( GRAPH_DIR_DOWN);
-    }
-
-        /**
-     * Return next edge of the same node in given direction
-     */
-    inline Edge* nextEdge()
-    {
-        return ( graph_it.next() != NULL )? graph_it.next()->data() : NULL;
-    }
-
-    /**
-     * Return next edge of the same node in given direction
-     */
-    inline Edge* nextEdgeInDir( GraphDir dir)
-    {
-        GraphDir rdir = revDir( dir);
-        return ( n_it[ rdir].next() != NULL )? n_it[ rdir].next()->data() : NULL;
-    }
-
-    /**
-     * Next edge defaults
-     */
-    inline Edge* nextSucc()
-    {
-        return nextEdgeInDir( GRAPH_DIR_DOWN);
-    }
-    inline Edge* nextPred()
-    {
-        return nextEdgeInDir( GRAPH_DIR_UP);
-    }
-
-    /**
-     * Print edge in dot fomat to stdout
-     */
-    virtual void debugPrint();
-};
+Node *
+Edge::GetNode (GraphDir dir) const
+{
+  return m_nodes[dir];
+}
+
+Node *
+Edge::GetPred (void) const
+{
+  return m_nodes[GRAPH_DIR_UP];
+}
+
+Node *
+Edge::GetSucc (void) const
+{
+  return m_nodes[GRAPH_DIR_DOWN];
+}
+
+Edge *
+Edge::GetNextEdge (void) const
+{
+  EdgeListItem *item = m_graphItem.GetNext ();
+  return item ? item->GetData () : 0;
+}
+
+Edge *
+Edge::GetNextEdgeInDir (GraphDir dir) const
+{
+  // the node iterating its edges in dir is at the other end
+  EdgeListItem *item = m_nodeItems[RevDir (dir)].GetNext ();
+  return item ? item->GetData () : 0;
+}
+
+Edge *
+Edge::GetNextSucc (void) const
+{
+  return GetNextEdgeInDir (GRAPH_DIR_DOWN);
+}
+
+Edge *
+Edge::GetNextPred (void) const
+{
+  return GetNextEdgeInDir (GRAPH_DIR_UP);
+}
+
+} // namespace graph
 
-#endif
+#endif /* EDGE_H */
@@ -21,10 +21,8 @@
 #ifndef GRAPH_COMMON_H
 #define GRAPH_COMMON_H
 
-#include <list>
-#include "num.h"
-#include "marker.h"
-#include "graph_error.h"
+#include <stdint.h>
+#include "list-item.h"
 
 namespace graph {
 
@@ -41,27 +39,62 @@ typedef uint32_t GraphNum;
  */
 enum GraphDir
 {
-    GRAPH_DIR_UP,
-    GRAPH_DIR_DOWN,
-    GRAPH_DIRS_NUM
+  GRAPH_DIR_UP,
+  GRAPH_DIR_DOWN,
+  GRAPH_DIRS_NUM
 };
+
+/**
+ * \enum Possible graph errors
+ */
+enum GraphErrorType
+{
+  /** Some error occured */
+  GRAPH_ERROR_GENERIC,
+  /** Node or edge belongs to another graph */
+  GRAPH_ERROR_FOREIGN_OBJECT,
+  /** XML file can't be parsed or doesn't describe a graph */
+  GRAPH_ERROR_XML_READ,
+  /** XML file can't be written */
+  GRAPH_ERROR_XML_WRITE,
+  /** Binary file can't be mapped or is truncated or corrupt */
+  GRAPH_ERROR_BINARY_READ,
+  /** Binary file can't be written */
+  GRAPH_ERROR_BINARY_WRITE,
+  /** Number of error types */
+  GRAPH_ERROR_NUM
+};
+
 /**
- * Return direction that is reverse to given one
+ * \returns direction that is reverse to given one
+ */
+inline GraphDir
+RevDir (GraphDir dir)
+{
+  return dir == GRAPH_DIR_UP ? GRAPH_DIR_DOWN : GRAPH_DIR_UP;
+}
+
+/**
+ * \brief throws error unless condition holds
+ *
+ * Errors of the graph library are values of the *ErrorType enums
  */
-/*inline GraphDir
-revDir (GraphDir dir)
+template <class T>
+inline void
+GraphAssert (bool condition, T error)
 {
-    graphassert( GRAPH_DIRS_NUM == 2);
-    return ( dir == GRAPH_DIR_UP)? GRAPH_DIR_DOWN: GRAPH_DIR_UP;
+  if (!condition)
+    {
+      throw error;
+    }
 }
-*/
 
-const GraphNum GRAPH_MAX_NODE_NUM  = (GraphNum)-1;
-const GraphNum GRAPH_MAX_EDGE_NUM  = (GraphNum)-1;
+const GraphNum GRAPH_MAX_NODE_NUM = (GraphNum) -1;
+const GraphNum GRAPH_MAX_EDGE_NUM = (GraphNum) -1;
 
-//typedef ListItem<Node> NodeListItem;
-//typedef ListItem<Edge> EdgeListItem;
+typedef ListItem<Node> NodeListItem;
+typedef ListItem<Edge> EdgeListItem;
 
-}; // namespace graph
+} // namespace graph
 
-#endif /* MARKER_H */
+#endif /* GRAPH_COMMON_H */
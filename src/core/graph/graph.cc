@@ -0,0 +1,779 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <libxml/parser.h>
+#include <libxml/xmlreader.h>
+#include "graph.h"
+#include "xml-util.h"
+
+namespace graph {
+
+namespace {
+
+/**
+ * \brief append a new item of node to the list [first, last]
+ */
+void
+AppendNode (Arena *arena, NodeListItem *&first, NodeListItem *&last, Node *node)
+{
+  NodeListItem *item = new (arena) NodeListItem (node);
+  if (last)
+    {
+      item->AttachAfter (last);
+    }
+  else
+    {
+      first = item;
+    }
+  last = item;
+}
+
+/**
+ * Binary format constants
+ */
+const char BINARY_MAGIC[8] = { 'N', 'X', 'G', 'R', 'A', 'P', 'H', 0 };
+const uint32_t BINARY_BYTE_ORDER = 0x01020304;
+const uint32_t BINARY_VERSION = 1;
+const size_t BINARY_FLUSH_SIZE = 1 << 20;
+
+enum BinaryBlock
+{
+  BINARY_BLOCK_GRAPH = 1,
+  BINARY_BLOCK_NODES = 2,
+  BINARY_BLOCK_EDGES = 3
+};
+
+/**
+ * \brief write the buffer to file and empty it
+ */
+void
+Flush (BinaryWriter &writer, FILE *file)
+{
+  if (writer.GetSize ())
+    {
+      fwrite (writer.GetData (), writer.GetSize (), 1, file);
+      writer.Clear ();
+    }
+}
+
+/**
+ * \brief write block header with a length to be set by EndBlock
+ * \returns position of the block data
+ */
+off_t
+BeginBlock (BinaryWriter &writer, FILE *file, uint32_t tag)
+{
+  writer.WriteUint32 (tag);
+  writer.WriteUint64 (0);
+  Flush (writer, file);
+  return ftello (file);
+}
+
+void
+EndBlock (BinaryWriter &writer, FILE *file, off_t start)
+{
+  Flush (writer, file);
+  off_t end = ftello (file);
+  uint64_t length = end - start;
+  fseeko (file, start - sizeof (length), SEEK_SET);
+  fwrite (&length, sizeof (length), 1, file);
+  fseeko (file, end, SEEK_SET);
+}
+
+} // namespace
+
+Graph::Graph ()
+{
+  Init ();
+}
+
+Graph::Graph (const char *filename)
+{
+  Init ();
+  ReadFromXml (filename);
+}
+
+Graph::~Graph ()
+{
+  // the lists of nodes and edges die along with them
+  for (Edge *edge = GetFirstEdge (); edge; )
+    {
+      Edge *next = edge->GetNextEdge ();
+      Destroy (edge);
+      edge = next;
+    }
+  for (Node *node = GetFirstNode (); node; )
+    {
+      Node *next = node->GetNextNode ();
+      Destroy (node);
+      node = next;
+    }
+}
+
+template <class T>
+void
+Graph::Destroy (T *object)
+{
+  if (ArenaObject::IsAllocatedIn (dynamic_cast<void *> (object), &m_arena))
+    {
+      // m_arena releases the memory
+      object->~T ();
+    }
+  else
+    {
+      delete object;
+    }
+}
+
+void
+Graph::Init (void)
+{
+  m_firstNode = 0;
+  m_lastNode = 0;
+  m_nodeCount = 0;
+  m_nextNodeId = 0;
+  m_firstEdge = 0;
+  m_lastEdge = 0;
+  m_edgeCount = 0;
+  m_nextEdgeId = 0;
+}
+
+Node *
+Graph::CreateNode (void)
+{
+  return new (&m_arena) Node (this, IncNodeId ());
+}
+
+Edge *
+Graph::CreateEdge (Node *pred, Node *succ)
+{
+  return new (&m_arena) Edge (this, IncEdgeId (), pred, succ);
+}
+
+Node *
+Graph::NewNode (void)
+{
+  Node *node = CreateNode ();
+  if (m_lastNode)
+    {
+      node->m_graphItem.AttachAfter (m_lastNode);
+    }
+  else
+    {
+      m_firstNode = &node->m_graphItem;
+    }
+  m_lastNode = &node->m_graphItem;
+  m_nodeCount++;
+  return node;
+}
+
+Edge *
+Graph::NewEdge (Node *pred, Node *succ)
+{
+  GraphAssert<GraphErrorType> (pred && succ, GRAPH_ERROR_GENERIC);
+  GraphAssert<GraphErrorType> (pred->GetGraph () == this && succ->GetGraph () == this,
+                               GRAPH_ERROR_FOREIGN_OBJECT);
+
+  Edge *edge = CreateEdge (pred, succ);
+  if (m_lastEdge)
+    {
+      edge->m_graphItem.AttachAfter (m_lastEdge);
+    }
+  else
+    {
+      m_firstEdge = &edge->m_graphItem;
+    }
+  m_lastEdge = &edge->m_graphItem;
+  m_edgeCount++;
+  return edge;
+}
+
+void
+Graph::DetachNode (Node *node)
+{
+  NodeListItem *item = &node->m_graphItem;
+  if (m_firstNode == item)
+    {
+      m_firstNode = item->GetNext ();
+    }
+  if (m_lastNode == item)
+    {
+      m_lastNode = item->GetPrev ();
+    }
+  item->Detach ();
+  m_nodeCount--;
+}
+
+void
+Graph::DetachEdge (Edge *edge)
+{
+  EdgeListItem *item = &edge->m_graphItem;
+  if (m_firstEdge == item)
+    {
+      m_firstEdge = item->GetNext ();
+    }
+  if (m_lastEdge == item)
+    {
+      m_lastEdge = item->GetPrev ();
+    }
+  item->Detach ();
+  m_edgeCount--;
+}
+
+void
+Graph::RemoveEdge (Edge *edge)
+{
+  GraphAssert<GraphErrorType> (edge && edge->GetGraph () == this, GRAPH_ERROR_FOREIGN_OBJECT);
+  edge->DetachFromNode (GRAPH_DIR_UP);
+  edge->DetachFromNode (GRAPH_DIR_DOWN);
+  DetachEdge (edge);
+  delete edge;
+}
+
+void
+Graph::RemoveNode (Node *node)
+{
+  GraphAssert<GraphErrorType> (node && node->GetGraph () == this, GRAPH_ERROR_FOREIGN_OBJECT);
+  for (uint32_t dir = 0; dir < GRAPH_DIRS_NUM; ++dir)
+    {
+      while (Edge *edge = node->GetFirstEdgeInDir ((GraphDir) dir))
+        {
+          RemoveEdge (edge);
+        }
+    }
+  DetachNode (node);
+  delete node;
+}
+
+Node *
+Graph::InsertNodeOnEdge (Edge *edge)
+{
+  GraphAssert<GraphErrorType> (edge && edge->GetGraph () == this, GRAPH_ERROR_FOREIGN_OBJECT);
+  Node *succ = edge->GetSucc ();
+  Node *node = NewNode ();
+  edge->SetSucc (node);
+  NewEdge (node, succ);
+  return node;
+}
+
+void
+Graph::DebugPrint (void) const
+{
+  std::cout << "digraph {" << std::endl;
+  for (Node *node = GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      node->DebugPrint ();
+    }
+  for (Edge *edge = GetFirstEdge (); edge; edge = edge->GetNextEdge ())
+    {
+      edge->DebugPrint ();
+    }
+  std::cout << "}" << std::endl;
+}
+
+NodeListItem *
+Graph::DFS (Numeration num)
+{
+  NodeListItem *first = 0;
+  NodeListItem *last = 0;
+  GraphNum number = 0;
+
+  // next successor edge to follow of every node on the path, an
+  // explicit stack keeps long paths off the call stack
+  std::vector<Edge *> stack;
+  for (Node *root = GetFirstNode (); root; root = root->GetNextNode ())
+    {
+      if (root->IsNumbered (num))
+        {
+          continue;
+        }
+      root->SetNumber (num, number++);
+      AppendNode (&m_arena, first, last, root);
+      stack.push_back (root->GetFirstSucc ());
+
+      while (!stack.empty ())
+        {
+          Edge *edge = stack.back ();
+          if (!edge)
+            {
+              stack.pop_back ();
+              continue;
+            }
+          stack.back () = edge->GetNextSucc ();
+
+          Node *succ = edge->GetSucc ();
+          if (succ->IsNumbered (num))
+            {
+              continue;
+            }
+          succ->SetNumber (num, number++);
+          AppendNode (&m_arena, first, last, succ);
+          stack.push_back (succ->GetFirstSucc ());
+        }
+    }
+  return first;
+}
+
+NodeListItem *
+Graph::BFS (Numeration num)
+{
+  NodeListItem *first = 0;
+  NodeListItem *last = 0;
+  GraphNum number = 0;
+
+  for (Node *root = GetFirstNode (); root; root = root->GetNextNode ())
+    {
+      if (root->IsNumbered (num))
+        {
+          continue;
+        }
+      root->SetNumber (num, number++);
+      AppendNode (&m_arena, first, last, root);
+
+      // the tail of the result list is the queue
+      for (NodeListItem *head = last; head; head = head->GetNext ())
+        {
+          for (Edge *edge = head->GetData ()->GetFirstSucc (); edge; edge = edge->GetNextSucc ())
+            {
+              Node *succ = edge->GetSucc ();
+              if (succ->IsNumbered (num))
+                {
+                  continue;
+                }
+              succ->SetNumber (num, number++);
+              AppendNode (&m_arena, first, last, succ);
+            }
+        }
+    }
+  return first;
+}
+
+void
+Graph::ClearMarkersInObjects (void)
+{
+  for (Node *node = GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      ClearUnusedMarkers (node);
+    }
+  for (Edge *edge = GetFirstEdge (); edge; edge = edge->GetNextEdge ())
+    {
+      ClearUnusedMarkers (edge);
+    }
+}
+
+void
+Graph::ClearNumerationsInObjects (void)
+{
+  for (Node *node = GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      ClearUnusedNumerations (node);
+    }
+  for (Edge *edge = GetFirstEdge (); edge; edge = edge->GetNextEdge ())
+    {
+      ClearUnusedNumerations (edge);
+    }
+}
+
+//// XML
+
+void
+Graph::ReadAttribsFromXml (xmlNode *)
+{
+}
+
+void
+Graph::WriteAttribsByXmlWriter (xmlTextWriterPtr)
+{
+}
+
+void
+Graph::ReadFromXml (const char *filename)
+{
+  xmlTextReaderPtr reader = xmlReaderForFile (filename, 0, 0);
+  GraphAssert<GraphErrorType> (reader != 0, GRAPH_ERROR_XML_READ);
+
+  try
+    {
+      ReadFromXmlReader (reader);
+    }
+  catch (...)
+    {
+      xmlFreeTextReader (reader);
+      throw;
+    }
+  xmlFreeTextReader (reader);
+}
+
+void
+Graph::ReadFromXmlReader (xmlTextReaderPtr reader)
+{
+  XmlNodeMap nodes;
+  bool root = false;
+
+  int result = xmlTextReaderRead (reader);
+  while (result == 1)
+    {
+      if (xmlTextReaderNodeType (reader) == XML_READER_TYPE_ELEMENT)
+        {
+          int depth = xmlTextReaderDepth (reader);
+          if (depth == 0)
+            {
+              // attributes of the start tag are already there
+              ReadGraphFromXml (xmlTextReaderCurrentNode (reader));
+              root = true;
+            }
+          else if (depth == 1)
+            {
+              // the element with its children, freed when the reader moves on
+              xmlNode *element = xmlTextReaderExpand (reader);
+              GraphAssert<GraphErrorType> (element != 0, GRAPH_ERROR_XML_READ);
+              if (!xmlStrcmp (element->name, BAD_CAST "node"))
+                {
+                  ReadNodeFromXml (element, nodes);
+                }
+              else if (!xmlStrcmp (element->name, BAD_CAST "edge"))
+                {
+                  ReadEdgeFromXml (element, nodes);
+                }
+              result = xmlTextReaderNext (reader);
+              continue;
+            }
+        }
+      result = xmlTextReaderRead (reader);
+    }
+  GraphAssert<GraphErrorType> (result == 0 && root, GRAPH_ERROR_XML_READ);
+}
+
+void
+Graph::ReadFromXmlDoc (xmlNode *root)
+{
+  ReadGraphFromXml (root);
+
+  XmlNodeMap nodes;
+  ReadNodesFromXmlDoc (root, nodes);
+  ReadEdgesFromXmlDoc (root, nodes);
+}
+
+void
+Graph::ReadGraphFromXml (xmlNode *root)
+{
+  GraphAssert<GraphErrorType> (!xmlStrcmp (root->name, BAD_CAST "graph"), GRAPH_ERROR_XML_READ);
+
+  GetXmlProp (root, "name", m_name);
+  GetXmlProp (root, "default_node_size", m_defaultNodeSize);
+  GetXmlProp (root, "max_node_id", m_maxNodeId);
+  ReadAttribsFromXml (root);
+}
+
+void
+Graph::ReadNodesFromXmlDoc (xmlNode *root, XmlNodeMap &nodes)
+{
+  for (xmlNode *i = root->children; i; i = i->next)
+    {
+      if (i->type == XML_ELEMENT_NODE && !xmlStrcmp (i->name, BAD_CAST "node"))
+        {
+          ReadNodeFromXml (i, nodes);
+        }
+    }
+}
+
+void
+Graph::ReadEdgesFromXmlDoc (xmlNode *root, const XmlNodeMap &nodes)
+{
+  for (xmlNode *i = root->children; i; i = i->next)
+    {
+      if (i->type == XML_ELEMENT_NODE && !xmlStrcmp (i->name, BAD_CAST "edge"))
+        {
+          ReadEdgeFromXml (i, nodes);
+        }
+    }
+}
+
+void
+Graph::ReadNodeFromXml (xmlNode *element, XmlNodeMap &nodes)
+{
+  uint32_t id;
+  GraphAssert<GraphErrorType> (GetXmlProp (element, "id", id), GRAPH_ERROR_XML_READ);
+  // ids in the file may be sparse, duplicates are rejected
+  std::pair<XmlNodeMap::iterator, bool> slot = nodes.insert (std::make_pair (id, (Node *) 0));
+  GraphAssert<GraphErrorType> (slot.second, GRAPH_ERROR_XML_READ);
+
+  Node *node = NewNode ();
+  node->ReadByXml (element);
+  slot.first->second = node;
+}
+
+void
+Graph::ReadEdgeFromXml (xmlNode *element, const XmlNodeMap &nodes)
+{
+  uint32_t from, to;
+  GraphAssert<GraphErrorType> (GetXmlProp (element, "from", from) && GetXmlProp (element, "to", to),
+                               GRAPH_ERROR_XML_READ);
+  XmlNodeMap::const_iterator pred = nodes.find (from);
+  XmlNodeMap::const_iterator succ = nodes.find (to);
+  GraphAssert<GraphErrorType> (pred != nodes.end () && succ != nodes.end (), GRAPH_ERROR_XML_READ);
+
+  Edge *edge = NewEdge (pred->second, succ->second);
+  edge->ReadByXml (element);
+}
+
+void
+Graph::WriteToXml (const char *filename)
+{
+  xmlTextWriterPtr writer = xmlNewTextWriterFilename (filename, 0);
+  GraphAssert<GraphErrorType> (writer != 0, GRAPH_ERROR_XML_WRITE);
+
+  xmlTextWriterSetIndent (writer, 1);
+  xmlTextWriterStartDocument (writer, 0, "UTF-8", 0);
+  xmlTextWriterStartElement (writer, BAD_CAST "graph");
+  xmlTextWriterWriteAttribute (writer, BAD_CAST "name", BAD_CAST m_name.c_str ());
+  xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "default_node_size", "%u", m_defaultNodeSize);
+  xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "max_node_id", "%u", m_maxNodeId);
+  WriteAttribsByXmlWriter (writer);
+  WriteNodesByXmlWriter (writer);
+  WriteEdgesByXmlWriter (writer);
+  xmlTextWriterEndElement (writer);
+  // flushes the file, fails if any write did
+  int result = xmlTextWriterEndDocument (writer);
+  xmlFreeTextWriter (writer);
+  GraphAssert<GraphErrorType> (result >= 0, GRAPH_ERROR_XML_WRITE);
+}
+
+void
+Graph::WriteNodesByXmlWriter (xmlTextWriterPtr writer)
+{
+  for (Node *node = GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      xmlTextWriterStartElement (writer, BAD_CAST "node");
+      xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "id", "%u", node->GetId ());
+      node->WriteByXmlWriter (writer);
+      xmlTextWriterEndElement (writer);
+    }
+}
+
+void
+Graph::WriteEdgesByXmlWriter (xmlTextWriterPtr writer)
+{
+  for (Edge *edge = GetFirstEdge (); edge; edge = edge->GetNextEdge ())
+    {
+      xmlTextWriterStartElement (writer, BAD_CAST "edge");
+      xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "from", "%u", edge->GetPred ()->GetId ());
+      xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "to", "%u", edge->GetSucc ()->GetId ());
+      edge->WriteByXmlWriter (writer);
+      xmlTextWriterEndElement (writer);
+    }
+}
+
+//// Binary
+
+void
+Graph::ReadAttribsFromBinary (BinaryReader &)
+{
+}
+
+void
+Graph::WriteAttribsByBinaryWriter (BinaryWriter &)
+{
+}
+
+void
+Graph::WriteToBinary (const char *filename)
+{
+  FILE *file = fopen (filename, "wb");
+  GraphAssert<GraphErrorType> (file != 0, GRAPH_ERROR_BINARY_WRITE);
+
+  bool failed;
+  try
+    {
+      WriteBinaryBlocks (file);
+      failed = ferror (file) != 0;
+    }
+  catch (...)
+    {
+      // no partial file is left behind
+      fclose (file);
+      remove (filename);
+      throw;
+    }
+  failed = fclose (file) != 0 || failed;
+  if (failed)
+    {
+      remove (filename);
+    }
+  GraphAssert<GraphErrorType> (!failed, GRAPH_ERROR_BINARY_WRITE);
+}
+
+void
+Graph::WriteBinaryBlocks (FILE *file)
+{
+  BinaryWriter out;
+  BinaryWriter record;
+  out.Write (BINARY_MAGIC, sizeof (BINARY_MAGIC));
+  out.WriteUint32 (BINARY_BYTE_ORDER);
+  out.WriteUint32 (BINARY_VERSION);
+
+  off_t start = BeginBlock (out, file, BINARY_BLOCK_GRAPH);
+  out.WriteString (m_name);
+  out.WriteUint32 (m_defaultNodeSize);
+  out.WriteUint32 (m_maxNodeId);
+  WriteAttribsByBinaryWriter (record);
+  out.WriteUint32 (record.GetSize ());
+  out.Write (record.GetData (), record.GetSize ());
+  EndBlock (out, file, start);
+
+  // edges refer to the nodes by their position in the file
+  std::vector<uint32_t> positions (GetNodeIdLimit ());
+  uint32_t position = 0;
+  start = BeginBlock (out, file, BINARY_BLOCK_NODES);
+  out.WriteUint32 (m_nodeCount);
+  for (Node *node = GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      positions[node->GetId ()] = position++;
+      record.Clear ();
+      node->WriteByBinaryWriter (record);
+      out.WriteUint32 (record.GetSize ());
+      out.Write (record.GetData (), record.GetSize ());
+      if (out.GetSize () > BINARY_FLUSH_SIZE)
+        {
+          Flush (out, file);
+        }
+    }
+  EndBlock (out, file, start);
+
+  start = BeginBlock (out, file, BINARY_BLOCK_EDGES);
+  out.WriteUint32 (m_edgeCount);
+  for (Edge *edge = GetFirstEdge (); edge; edge = edge->GetNextEdge ())
+    {
+      out.WriteUint32 (positions[edge->GetPred ()->GetId ()]);
+      out.WriteUint32 (positions[edge->GetSucc ()->GetId ()]);
+      record.Clear ();
+      edge->WriteByBinaryWriter (record);
+      out.WriteUint32 (record.GetSize ());
+      out.Write (record.GetData (), record.GetSize ());
+      if (out.GetSize () > BINARY_FLUSH_SIZE)
+        {
+          Flush (out, file);
+        }
+    }
+  EndBlock (out, file, start);
+}
+
+void
+Graph::ReadFromBinary (const char *filename)
+{
+  int fd = open (filename, O_RDONLY);
+  GraphAssert<GraphErrorType> (fd >= 0, GRAPH_ERROR_BINARY_READ);
+
+  struct stat info;
+  void *data = MAP_FAILED;
+  if (fstat (fd, &info) == 0 && info.st_size > 0)
+    {
+      data = mmap (0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+  // the mapping outlives the descriptor
+  close (fd);
+  GraphAssert<GraphErrorType> (data != MAP_FAILED, GRAPH_ERROR_BINARY_READ);
+  posix_madvise (data, info.st_size, POSIX_MADV_SEQUENTIAL);
+
+  try
+    {
+      BinaryReader reader ((const char *) data, info.st_size);
+      ReadBinaryBlocks (reader);
+    }
+  catch (...)
+    {
+      munmap (data, info.st_size);
+      throw;
+    }
+  munmap (data, info.st_size);
+}
+
+void
+Graph::ReadBinaryBlocks (BinaryReader &reader)
+{
+  char magic[sizeof (BINARY_MAGIC)];
+  reader.Read (magic, sizeof (magic));
+  GraphAssert<GraphErrorType> (!memcmp (magic, BINARY_MAGIC, sizeof (magic)) &&
+                               reader.ReadUint32 () == BINARY_BYTE_ORDER &&
+                               reader.ReadUint32 () == BINARY_VERSION, GRAPH_ERROR_BINARY_READ);
+
+  std::vector<Node *> nodes;
+  while (reader.GetRemaining ())
+    {
+      uint32_t tag = reader.ReadUint32 ();
+      BinaryReader block = reader.ReadBlock (reader.ReadUint64 ());
+      switch (tag)
+        {
+        case BINARY_BLOCK_GRAPH:
+          {
+            m_name = block.ReadString ();
+            m_defaultNodeSize = block.ReadUint32 ();
+            m_maxNodeId = block.ReadUint32 ();
+            BinaryReader attribs = block.ReadBlock (block.ReadUint32 ());
+            ReadAttribsFromBinary (attribs);
+            break;
+          }
+        case BINARY_BLOCK_NODES:
+          {
+            uint32_t count = block.ReadUint32 ();
+            // every record has at least its length, a corrupt count must
+            // not reserve more than the block can hold
+            GraphAssert<GraphErrorType> (count <= block.GetRemaining () / 4, GRAPH_ERROR_BINARY_READ);
+            nodes.reserve (nodes.size () + count);
+            for (uint32_t i = 0; i < count; ++i)
+              {
+                BinaryReader record = block.ReadBlock (block.ReadUint32 ());
+                Node *node = NewNode ();
+                node->ReadByBinary (record);
+                nodes.push_back (node);
+              }
+            break;
+          }
+        case BINARY_BLOCK_EDGES:
+          {
+            uint32_t count = block.ReadUint32 ();
+            // ends, length and record
+            GraphAssert<GraphErrorType> (count <= block.GetRemaining () / 12, GRAPH_ERROR_BINARY_READ);
+            for (uint32_t i = 0; i < count; ++i)
+              {
+                uint32_t from = block.ReadUint32 ();
+                uint32_t to = block.ReadUint32 ();
+                GraphAssert<GraphErrorType> (from < nodes.size () && to < nodes.size (), GRAPH_ERROR_BINARY_READ);
+                BinaryReader record = block.ReadBlock (block.ReadUint32 ());
+                Edge *edge = NewEdge (nodes[from], nodes[to]);
+                edge->ReadByBinary (record);
+              }
+            break;
+          }
+        default:
+          // blocks of later versions are skipped
+          break;
+        }
+    }
+}
+
+} // namespace graph
@@ -1,224 +1,374 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include <cstdio>
+#include <map>
+#include <string>
 #include <vector>
+#include <libxml/tree.h>
+#include <libxml/xmlreader.h>
+#include <libxml/xmlwriter.h>
+#include "arena.h"
+#include "binary.h"
+#include "graph-common.h"
+#include "marker.h"
+#include "numeration.h"
+#include "node.h"
+#include "edge.h"
 
+namespace graph {
 
+/**
+ * \brief Properties of a graph stored along with it
+ */
 class GraphProperties
 {
-protected:
-        int default_node_size;
-        char * name_priv;
-        int max_node_id;
 public:
-    GraphProperties()
-    {
-        default_node_size = 10;
-            name_priv = NULL;
-            max_node_id = 0;
-    }
-    /**
-     * Data retrieving routines
-     */
-    inline int defaultNodeSize() const
-    {
-        return default_node_size;
-    }
-    inline char * name() const
-    {
-        return name_priv;
-    }
-
-    inline int maxNodeId() const
-    {
-        return max_node_id;
-    }
-    /**
-     * Data saving routines
-     */
-    inline void setDefaultNodeSize( int sz)
-    {
-        default_node_size = sz;
-    }
-    inline void setName( char *nm)
-    {
-        name_priv = nm;
-    }
-
-    inline void setMaxNodeId( int max_id)
-    {
-        max_node_id = max_id;
-    }
+  GraphProperties ()
+    : m_defaultNodeSize (10),
+      m_maxNodeId (0)
+  {
+  }
+  /**
+   * Data retrieving routines
+   */
+  inline uint32_t GetDefaultNodeSize (void) const
+  {
+    return m_defaultNodeSize;
+  }
+  inline const std::string &GetName (void) const
+  {
+    return m_name;
+  }
+  inline uint32_t GetMaxNodeId (void) const
+  {
+    return m_maxNodeId;
+  }
+  /**
+   * Data saving routines
+   */
+  inline void SetDefaultNodeSize (uint32_t size)
+  {
+    m_defaultNodeSize = size;
+  }
+  inline void SetName (const std::string &name)
+  {
+    m_name = name;
+  }
+  inline void SetMaxNodeId (uint32_t id)
+  {
+    m_maxNodeId = id;
+  }
+
+protected:
+  uint32_t    m_defaultNodeSize;
+  std::string m_name;
+  uint32_t    m_maxNodeId;
 };
 
-class Graph: public MarkerManager, public NumManager, public GraphProperties
+/**
+ * \brief Directed graph owning its nodes and edges
+ *
+ * Nodes and edges are kept in intrusive lists, every node also keeps
+ * lists of its predecessor and successor edges. They are allocated in
+ * an arena of the graph, which releases them at once when the graph is
+ * destroyed. Errors are reported by
+ * throwing the values of GraphErrorType, MarkerErrorType and
+ * NumErrorType.
+ */
+class Graph: public MarkerManager, public NumerationManager, public GraphProperties
 {
-    /* List of nodes and its iterator */
-    Node* first_node;
-    unsigned long int node_num;
-
-    /**
-     *  Id of next node. Incremented each time you create a node,
-     *  needed for nodes to have unique id. In DEBUG mode node id is not reused.
-     */
-    GraphNum node_next_id;
-
-    /* List of edges and its iterator */
-    Edge* first_edge;
-    unsigned long int edge_num;
-
-    /** Id of next edge. Incremented each time you create an edge,
-     *  needed for edges to have unique id. In DEBUG mode edge id is not reused.
-     */
-    GraphNum edge_next_id;
-
-        /** Initialization */
-        void init();
+public:
+  /** Constructor */
+  Graph ();
+  /**
+   * \brief Constructor by XML file
+   *
+   * Nodes and edges are created by this class, use ReadFromXml in
+   * subclasses which override CreateNode or CreateEdge
+   */
+  explicit Graph (const char *filename);
+  virtual ~Graph ();
+
+  /** Create new node in graph */
+  Node *NewNode (void);
+  /**
+   * Create edge between two nodes.
+   * We do not support creation of edge with undefined endpoints
+   */
+  Edge *NewEdge (Node *pred, Node *succ);
+  /**
+   * \brief detach edge from its nodes and the graph and delete it
+   */
+  virtual void RemoveEdge (Edge *edge);
+  /**
+   * \brief remove the edges of node, detach it from the graph and delete it
+   */
+  virtual void RemoveNode (Node *node);
+  /**
+   * \brief split edge by a new node
+   * \returns the new node, edge now ends at it and a new edge leads from it
+   * to the former successor
+   */
+  Node *InsertNodeOnEdge (Edge *edge);
+
+  /**
+   * \returns node quantity
+   */
+  inline size_t GetNodeCount (void) const
+  {
+    return m_nodeCount;
+  }
+  /**
+   * \returns edge quantity
+   */
+  inline size_t GetEdgeCount (void) const
+  {
+    return m_edgeCount;
+  }
+  /**
+   * \returns upper bound of the ids of the nodes of the graph
+   */
+  inline GraphNum GetNodeIdLimit (void) const
+  {
+    return m_nextNodeId;
+  }
+  /**
+   * \returns upper bound of the ids of the edges of the graph
+   */
+  inline GraphNum GetEdgeIdLimit (void) const
+  {
+    return m_nextEdgeId;
+  }
+  /**
+   * \returns first node, iterate further with Node::GetNextNode
+   */
+  inline Node *GetFirstNode (void) const
+  {
+    return m_firstNode ? m_firstNode->GetData () : 0;
+  }
+  /**
+   * \returns first edge, iterate further with Edge::GetNextEdge
+   */
+  inline Edge *GetFirstEdge (void) const
+  {
+    return m_firstEdge ? m_firstEdge->GetData () : 0;
+  }
+
+  /**
+   * Print graph to stdout in DOT format
+   */
+  virtual void DebugPrint (void) const;
+
+  /**
+   * \brief Obtain list of nodes in depth-first search order
+   *
+   * Nodes are visited along successor edges, starting from every node
+   * not yet numbered in num in the order of the graph, and numbered in
+   * num in the order of the visit. The list is allocated in the arena of
+   * the graph and must be freed with DeleteList before the graph is
+   * destroyed.
+   */
+  NodeListItem *DFS (Numeration num);
+  /**
+   * \brief Obtain list of nodes in breadth-first search order
+   *
+   * Same as DFS but in breadth-first order
+   */
+  NodeListItem *BFS (Numeration num);
+
+  /**
+   * \brief Add nodes and edges described by XML file to the graph
+   *
+   * The file is streamed, one node or edge element at a time, so memory
+   * doesn't grow with the size of the file. Nodes must precede the edges
+   * which refer to them, as WriteToXml writes them.
+   */
+  void ReadFromXml (const char *filename);
+  /**
+   * \brief Add nodes and edges read from reader to the graph, see
+   * ReadFromXml
+   */
+  void ReadFromXmlReader (xmlTextReaderPtr reader);
+  /**
+   * \brief Add nodes and edges described by graph element of a document
+   * in memory to the graph, in any order
+   */
+  void ReadFromXmlDoc (xmlNode *root);
+  /**
+   * \brief Write the graph to XML file
+   */
+  void WriteToXml (const char *filename);
+
+  /**
+   * \brief Add nodes and edges of a file in the binary format to the graph
+   *
+   * The file is mapped into memory and the nodes and edges are created
+   * in one pass over it.
+   */
+  void ReadFromBinary (const char *filename);
+  /**
+   * \brief Write the graph to file in the binary format
+   *
+   * The file starts with a header recording the byte order, followed by
+   * length prefixed blocks of the graph properties, the nodes and the
+   * edges. Every node and edge record carries its own length, so that
+   * subclasses may add attributes to it.
+   */
+  void WriteToBinary (const char *filename);
+
 protected:
-    /** Increment node_next_id and return previous one */
-    inline GraphNum incNodeId()
-    {
-        return node_next_id++;
-    }
-    /** Increment edge_next_id and return previous one */
-    inline GraphNum incEdgeId()
-    {
-        return edge_next_id++;
-    }
-
-    /** Allocation of memory for Edge */
-    virtual Edge * createEdge( Node * pred, Node * succ);
-
-    /** Allocation of memory for Node */
-    virtual Node * createNode();
+  /** Nodes created while reading a file, keyed by their ids in the file */
+  typedef std::map<uint32_t, Node *> XmlNodeMap;
 
-public:
-    /** Constructor */
-    Graph();
-
-        /** Constructor by XML file */
-        Graph( char * filename);
-
-        ~Graph();
-
-        /**
-         *  Reading form XML
-         */
-        xmlDoc *xml_doc;
-        virtual void readAttribsFromXml (xmlNode * a_node) {}//for additional properties
-        void readNodesFromXmlDoc( xmlNode * a_node);
-        void readEdgesFromXmlDoc( xmlNode * a_node, vector<Node *> nodes);
-        void readFromXmlDoc( xmlNode * a_node);
-        void readFromXml(const char *filename);
-
-        void writeToXml(const char *filename);
-        void writeNodesByXmlWriter( xmlTextWriterPtr writer);
-        void writeEdgesByXmlWriter( xmlTextWriterPtr writer);
-        virtual void writeAttribsByXmlWriter (xmlTextWriterPtr writer) {}//for additional properties
-
-    /** Create new node in graph */
-    Node * newNode();
-
-    /**
-     * Create edge between two nodes.
-     * We do not support creation of edge with undefined endpoints
-     */
-    Edge * newEdge( Node * pred, Node * succ);
-
-    /**
-     * Remove node from node list of graph
-     */
-    inline void detachNode( Node* n)
-    {
-        graphassert( isNotNullP( n));
-        if( first_node == n)
-        {
-           first_node = n->nextNode();
-        }
-                n->detachFromGraph();
-                --node_num;
-    }
-
-    /**
-     * Remove edge from edge list of graph
-     */
-    inline void detachEdge( Edge* e)
-    {
-        graphassert( isNotNullP( e));
-        if( first_edge == e)
-        {
-            first_edge = e->nextEdge();
-        }
-        e->detachFromGraph();
-                --edge_num;
-    }
-
-        virtual void removeEdge (Edge* e);
-        virtual void removeNode (Node* n);
-
-        /**
-        * Insert new node on edge in graph
-        */
-        Node * insertNodeOnEdge( Edge* e);
-
-    /**
-     * Return node quantity
-     */
-    inline size_t getNodeCount() const
-    {
-        return node_num;
-    }
-
-    /**
-     * Return edge quantity
-     */
-    inline size_t getEdgeCount() const
-    {
-        return edge_num;
-    }
-    /***
-     * Iteration through edges implementation
-     *
-     * Initialize iterator with first edge and return this edge
-     */
-    inline Edge* firstEdge()
-    {
-        return first_edge;
-    }
-
-    /***
-     * Iteration through nodes implementation
-     *
-     * Initialize iterator with first node and return this node
-     */
-    inline Node* firstNode()
-    {
-        return first_node;
-    }
-
-    /**
-     * Print graph to stdout in DOT format
-     */
-    virtual void debugPrint();
-
-    /**
-     * Obtain list of nodes in depth-first search order
-     */
-    virtual NodeListItem* DFS( Numeration n);
-        /**
-     * Obtain list of nodes in breadth-first search order
-     */
-    virtual NodeListItem* BFS( Numeration n);
-
-    /**
-     * Clear unused markers from marked objects
-     */
-    void clearMarkersInObjects();
-
-    /**
-     * Clear unused numerations from numbered objects
-     */
-    void clearNumerationsInObjects();
+  /** Increment node id counter and return previous one */
+  inline GraphNum IncNodeId (void)
+  {
+    return m_nextNodeId++;
+  }
+  /** Increment edge id counter and return previous one */
+  inline GraphNum IncEdgeId (void)
+  {
+    return m_nextEdgeId++;
+  }
+  /**
+   * \brief Allocation of memory for Node
+   *
+   * Subclasses create their nodes with new (GetArena ()) to allocate
+   * them in the arena of the graph, nodes created with plain new live on
+   * the heap and are deleted one by one
+   */
+  virtual Node *CreateNode (void);
+  /**
+   * \brief Allocation of memory for Edge, see CreateNode
+   */
+  virtual Edge *CreateEdge (Node *pred, Node *succ);
+  /**
+   * \returns arena holding the nodes, edges and list items of the graph
+   */
+  inline Arena *GetArena (void)
+  {
+    return &m_arena;
+  }
+
+  /**
+   * \brief read additional properties from attributes of the graph element
+   */
+  virtual void ReadAttribsFromXml (xmlNode *root);
+  /**
+   * \brief write additional properties as attributes of the graph element
+   */
+  virtual void WriteAttribsByXmlWriter (xmlTextWriterPtr writer);
+  /**
+   * \param root graph element
+   * \param nodes filled with the created nodes keyed by their ids in the file
+   */
+  void ReadNodesFromXmlDoc (xmlNode *root, XmlNodeMap &nodes);
+  /**
+   * \param root graph element
+   * \param nodes nodes keyed by their ids in the file
+   */
+  void ReadEdgesFromXmlDoc (xmlNode *root, const XmlNodeMap &nodes);
+  /**
+   * \brief read properties from graph element, its children are ignored
+   */
+  void ReadGraphFromXml (xmlNode *root);
+  /**
+   * \brief create node described by node element
+   * \param nodes created nodes keyed by their ids in the file
+   */
+  void ReadNodeFromXml (xmlNode *element, XmlNodeMap &nodes);
+  /**
+   * \brief create edge described by edge element
+   * \param nodes created nodes keyed by their ids in the file
+   */
+  void ReadEdgeFromXml (xmlNode *element, const XmlNodeMap &nodes);
+  void WriteNodesByXmlWriter (xmlTextWriterPtr writer);
+  void WriteEdgesByXmlWriter (xmlTextWriterPtr writer);
+
+  /**
+   * \brief read additional properties from the graph block
+   */
+  virtual void ReadAttribsFromBinary (BinaryReader &reader);
+  /**
+   * \brief write additional properties to the graph block
+   */
+  virtual void WriteAttribsByBinaryWriter (BinaryWriter &writer);
+
+  /**
+   * Clear unused markers from marked objects
+   */
+  virtual void ClearMarkersInObjects (void);
+  /**
+   * Clear unused numerations from numbered objects
+   */
+  virtual void ClearNumerationsInObjects (void);
+
+private:
+  Graph (const Graph &);
+  Graph &operator = (const Graph &);
+
+  /** Initialization */
+  void Init (void);
+  /**
+   * \brief remove node from node list of graph
+   */
+  void DetachNode (Node *node);
+  /**
+   * \brief remove edge from edge list of graph
+   */
+  void DetachEdge (Edge *edge);
+  /**
+   * \brief create nodes and edges from the blocks of a binary file
+   */
+  void ReadBinaryBlocks (BinaryReader &reader);
+  /**
+   * \brief write the blocks of a binary file, failed writes are left to ferror
+   */
+  void WriteBinaryBlocks (FILE *file);
+  /**
+   * \brief destroy object of the graph, the memory of objects in the arena
+   * is released along with it
+   */
+  template <class T>
+  void Destroy (T *object);
+
+  Arena        m_arena;
+  NodeListItem *m_firstNode;
+  NodeListItem *m_lastNode;
+  size_t       m_nodeCount;
+  /**
+   *  Id of next node. Incremented each time you create a node,
+   *  needed for nodes to have unique id. Ids are not reused.
+   */
+  GraphNum     m_nextNodeId;
+
+  EdgeListItem *m_firstEdge;
+  EdgeListItem *m_lastEdge;
+  size_t       m_edgeCount;
+  GraphNum     m_nextEdgeId;
 };
 
-#endif
+} // namespace graph
+
+#endif /* GRAPH_H */
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef LIST_ITEM_H
+#define LIST_ITEM_H
+
+#include "arena.h"
+
+namespace graph {
+
+/**
+ * \brief Item of an intrusive doubly linked list
+ *
+ * Nodes and edges embed the items which keep them in the lists of the
+ * graph and of their adjacent nodes, so that attaching and detaching
+ * never allocates. Free standing items may be allocated in an Arena.
+ */
+template <class T>
+class ListItem : public ArenaObject
+{
+public:
+  ListItem ();
+  explicit ListItem (T *data);
+
+  T *GetData (void) const;
+  void SetData (T *data);
+  ListItem<T> *GetNext (void) const;
+  ListItem<T> *GetPrev (void) const;
+  /**
+   * \brief insert this detached item after item
+   */
+  void AttachAfter (ListItem<T> *item);
+  /**
+   * \brief insert this detached item before item
+   */
+  void AttachBefore (ListItem<T> *item);
+  /**
+   * \brief remove item from its list, the neighbours are linked together
+   */
+  void Detach (void);
+
+private:
+  T *m_data;
+  ListItem<T> *m_prev;
+  ListItem<T> *m_next;
+};
+
+/**
+ * \brief delete all items of a list allocated with new or new (arena)
+ */
+template <class T>
+void
+DeleteList (ListItem<T> *first)
+{
+  while (first)
+    {
+      ListItem<T> *next = first->GetNext ();
+      delete first;
+      first = next;
+    }
+}
+
+template <class T>
+ListItem<T>::ListItem ()
+  : m_data (0),
+    m_prev (0),
+    m_next (0)
+{
+}
+
+template <class T>
+ListItem<T>::ListItem (T *data)
+  : m_data (data),
+    m_prev (0),
+    m_next (0)
+{
+}
+
+template <class T>
+inline T *
+ListItem<T>::GetData (void) const
+{
+  return m_data;
+}
+
+template <class T>
+inline void
+ListItem<T>::SetData (T *data)
+{
+  m_data = data;
+}
+
+template <class T>
+inline ListItem<T> *
+ListItem<T>::GetNext (void) const
+{
+  return m_next;
+}
+
+template <class T>
+inline ListItem<T> *
+ListItem<T>::GetPrev (void) const
+{
+  return m_prev;
+}
+
+template <class T>
+void
+ListItem<T>::AttachAfter (ListItem<T> *item)
+{
+  m_prev = item;
+  m_next = item->m_next;
+  if (m_next)
+    {
+      m_next->m_prev = this;
+    }
+  item->m_next = this;
+}
+
+template <class T>
+void
+ListItem<T>::AttachBefore (ListItem<T> *item)
+{
+  m_next = item;
+  m_prev = item->m_prev;
+  if (m_prev)
+    {
+      m_prev->m_next = this;
+    }
+  item->m_prev = this;
+}
+
+template <class T>
+void
+ListItem<T>::Detach (void)
+{
+  if (m_prev)
+    {
+      m_prev->m_next = m_next;
+    }
+  if (m_next)
+    {
+      m_next->m_prev = m_prev;
+    }
+  m_prev = 0;
+  m_next = 0;
+}
+
+} // namespace graph
+
+#endif /* LIST_ITEM_H */
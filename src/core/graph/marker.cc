@@ -18,6 +18,9 @@
  * Author: Andrey Churin <aachurin@gmail.com>
  */
 
+#include "marker.h"
+#include "graph-common.h"
+
 namespace graph {
 
 Marked::Marked ()
@@ -28,44 +31,9 @@ Marked::Marked ()
     }
 }
 
-bool
-Marked::Mark (const Marker &marker)
-{
-  if (m_markers[marker.index] == marker.value)
-    {
-      return false;
-    }
-
-  m_markers[marker.index] = marker.value;
-  return true;
-}
-
-bool
-Marked::isMarked (const Marker &marker)
-{
-  return m_markers[marker.index] == marker.value;
-}
-
-bool
-Marked::Unmark (const Marker &marker)
-{
-  if (m_markers[marker.index] == marker.value)
-    {
-      m_markers[marker.index] = GRAPH_MARKER_CLEAN;
-      return true;
-    }
-
-  return false;
-}
-
-void Clear (MarkerIndex i)
-{
-   m_markers[i] = GRAPH_MARKER_CLEAN;
-}
-
 //// MarkerManager
 
-MarkerManager::MarkerManager()
+MarkerManager::MarkerManager ()
 {
   for (MarkerIndex i = 0; i < MAX_GRAPH_MARKERS; i++)
     {
@@ -76,14 +44,18 @@ MarkerManager::MarkerManager()
   m_last = GRAPH_MARKER_FIRST;
 }
 
+MarkerManager::~MarkerManager ()
+{
+}
+
 Marker
-MarkerManager::NewMarker()
+MarkerManager::NewMarker (void)
 {
   Marker marker;
   marker.index = FindFreeIndex ();
-  m_isused[marker.index] = true;
   marker.value = FindNextFreeValue ();
-  markers [marker.index] = marker.value;
+  m_isused[marker.index] = true;
+  m_markers[marker.index] = marker.value;
   return marker;
 }
 
@@ -94,7 +66,7 @@ MarkerManager::FreeMarker (const Marker &marker)
 }
 
 MarkerIndex
-MarkerManager::FindFreeIndex(void) const
+MarkerManager::FindFreeIndex (void) const
 {
   for (MarkerIndex i = 0; i < MAX_GRAPH_MARKERS; i++)
     {
@@ -128,8 +100,10 @@ MarkerManager::IsValueBusy (MarkerValue val) const
 {
   for (MarkerIndex i = 0; i < MAX_GRAPH_MARKERS; i++)
     {
-      if (m_isused[i] && markers[i] == val)
+      if (m_isused[i] && m_markers[i] == val)
+        {
           return true;
+        }
     }
 
   return false;
@@ -138,19 +112,24 @@ MarkerManager::IsValueBusy (MarkerValue val) const
 MarkerValue
 MarkerManager::FindNextFreeValue (void)
 {
-  MarkerIndex i = 0;
   bool reached_limit = false;
-  MarkerValue res = last;
 
-  while (IsValueBusy (res))
+  // values are never reused before the objects are cleaned, so that
+  // marks left by freed markers don't look like marks of a new one
+  MarkerValue res = NextValue ();
+  while (res == GRAPH_MARKER_FIRST || IsValueBusy (res))
     {
-      if (res == GRAPH_MARKER_LAST)
+      if (res == GRAPH_MARKER_FIRST)
         {
-          assert<MarkerErrorType> (!reached_limit, M_ERROR_OUT_OF_VALUES);
+          GraphAssert<MarkerErrorType> (!reached_limit, M_ERROR_OUT_OF_VALUES);
           ClearMarkersInObjects ();
           reached_limit = true;
+          if (!IsValueBusy (res))
+            {
+              break;
+            }
         }
-      res = NextValue();
+      res = NextValue ();
     }
   return res;
 }
@@ -160,8 +139,11 @@ MarkerManager::ClearUnusedMarkers (Marked *marked) const
 {
   for (MarkerIndex i = 0; i < MAX_GRAPH_MARKERS; i++)
     {
-      if (!m_isused[i]) marked->Clear (i);
+      if (!m_isused[i] || marked->m_markers[i] != m_markers[i])
+        {
+          marked->Clear (i);
+        }
     }
 }
 
-}; // namespace graph
+} // namespace graph
@@ -21,6 +21,8 @@
 #ifndef MARKER_H
 #define MARKER_H
 
+#include <stdint.h>
+
 namespace graph {
 
 typedef uint16_t MarkerIndex;
@@ -80,7 +82,7 @@ public:
    * \param marker
    * \returns true if node is marked with this marker
   */
-  inline bool IsMarked (const Marker &marker);
+  inline bool IsMarked (const Marker &marker) const;
   /**
    * \param marker
    * \returns true if node has been marked with this marker and unmarks it
@@ -92,17 +94,22 @@ public:
   inline void Clear (MarkerIndex i);
 
 private:
+  friend class MarkerManager;
   MarkerValue m_markers[MAX_GRAPH_MARKERS];
 };
 
 
 /**
  * \brief Marker manager implementation
+ *
+ * The markers are stored in the marked objects, see MarkerTable for
+ * markers kept apart from them.
  */
 class MarkerManager
 {
 public:
   MarkerManager ();
+  virtual ~MarkerManager ();
   /**
    * \brief Acquire new marker. Markers MUST be freed after use,otherwise you run to markers number limit.
    */
@@ -110,33 +117,34 @@ public:
   /**
    * \brief Free marker
    */
-  inline void FreeMarker (const Marker &marker);
+  void FreeMarker (const Marker &marker);
 
 protected:
   /**
    * \brief Find free index
    */
-  inline MarkerIndex FindFreeIndex (void) const;
+  MarkerIndex FindFreeIndex (void) const;
   /**
    * \brief Increment marker value
    */
-  inline MarkerValue NextValue (void);
+  MarkerValue NextValue (void);
   /**
-   * \brief MUST BE implemented in inhereted class
+   * \brief MUST BE implemented in inhereted class, calls
+   * ClearUnusedMarkers for every marked object
    */
-  virtual void ClearMarkersInObjects() = 0;
+  virtual void ClearMarkersInObjects (void) = 0;
   /**
    * \brief Check if this value is busy
    */
-  inline bool IsValueBusy (MarkerValue val) const;
+  bool IsValueBusy (MarkerValue val) const;
   /**
    * \returns next free value
    */
-  inline MarkerValue FindNextFreeValue (void);
+  MarkerValue FindNextFreeValue (void);
   /**
-   * \brief Clears unused markers in given object
+   * \brief Clears the values of freed markers in given object
    */
-  inline void ClearUnusedMarkers (Marked *marked) const;
+  void ClearUnusedMarkers (Marked *marked) const;
 
 private:
   MarkerValue m_markers[MAX_GRAPH_MARKERS];
@@ -144,6 +152,42 @@ private:
   MarkerValue m_last;
 };
 
-}; // namespace graph
+bool
+Marked::Mark (const Marker &marker)
+{
+  if (m_markers[marker.index] == marker.value)
+    {
+      return false;
+    }
+
+  m_markers[marker.index] = marker.value;
+  return true;
+}
+
+bool
+Marked::IsMarked (const Marker &marker) const
+{
+  return m_markers[marker.index] == marker.value;
+}
+
+bool
+Marked::Unmark (const Marker &marker)
+{
+  if (m_markers[marker.index] == marker.value)
+    {
+      m_markers[marker.index] = GRAPH_MARKER_CLEAN;
+      return true;
+    }
+
+  return false;
+}
+
+void
+Marked::Clear (MarkerIndex i)
+{
+  m_markers[i] = GRAPH_MARKER_CLEAN;
+}
+
+} // namespace graph
 
 #endif /* MARKER_H */
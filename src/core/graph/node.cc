@@ -0,0 +1,94 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <iostream>
+#include "node.h"
+#include "edge.h"
+#include "xml-util.h"
+
+namespace graph {
+
+Node::Node (Graph *graph, GraphNum id)
+  : m_id (id),
+    m_userId (id),
+    m_graph (graph),
+    m_graphItem (this)
+{
+  m_edges[GRAPH_DIR_UP] = 0;
+  m_edges[GRAPH_DIR_DOWN] = 0;
+}
+
+Node::~Node ()
+{
+}
+
+void
+Node::AddEdgeInDir (Edge *edge, GraphDir dir)
+{
+  EdgeListItem *item = &edge->m_nodeItems[RevDir (dir)];
+  if (m_edges[dir])
+    {
+      item->AttachBefore (m_edges[dir]);
+    }
+  m_edges[dir] = item;
+}
+
+void
+Node::DeleteEdgeInDir (Edge *edge, GraphDir dir)
+{
+  EdgeListItem *item = &edge->m_nodeItems[RevDir (dir)];
+  if (m_edges[dir] == item)
+    {
+      m_edges[dir] = item->GetNext ();
+    }
+  item->Detach ();
+}
+
+void
+Node::DebugPrint (void) const
+{
+  std::cout << "  n" << m_id << " [label=\"" << m_userId << "\"];" << std::endl;
+}
+
+void
+Node::WriteByXmlWriter (xmlTextWriterPtr writer)
+{
+  xmlTextWriterWriteFormatAttribute (writer, BAD_CAST "user", "%u", m_userId);
+}
+
+void
+Node::ReadByXml (xmlNode *node)
+{
+  GetXmlProp (node, "user", m_userId);
+}
+
+void
+Node::WriteByBinaryWriter (BinaryWriter &writer)
+{
+  writer.WriteUint32 (m_userId);
+}
+
+void
+Node::ReadByBinary (BinaryReader &reader)
+{
+  m_userId = reader.ReadUint32 ();
+}
+
+} // namespace graph
@@ -21,6 +21,11 @@
 #ifndef NODE_H
 #define NODE_H
 
+#include <libxml/tree.h>
+#include <libxml/xmlwriter.h>
+#include "arena.h"
+#include "binary.h"
+#include "graph-common.h"
 #include "marker.h"
 #include "numeration.h"
 
@@ -29,164 +34,145 @@ namespace graph {
 /**
  * \brief Node representation class.
  */
-class Node: public Marked, public Numbered
+class Node: public Marked, public Numbered, public ArenaObject
 {
 public:
-  virtual ~Node();
+  virtual ~Node ();
 
-  inline uint32_t GetId (void) const;
+  /**
+   * \returns unique id given by the graph
+   */
+  inline GraphNum GetId (void) const;
   inline uint32_t GetUserId (void) const;
   inline void SetUserId (uint32_t id);
   /**
    * \brief get node's corresponding graph
    */
-  inline Graph* GetGraph (void) const
+  inline Graph *GetGraph (void) const;
   /**
-   * Add edge to node in specified direction
+   * \returns first edge in specified direction, iterate further with
+   * Edge::GetNextEdgeInDir
    */
-  virtual void AddEdgeInDir (Edge *edge, GraphDir dir);
+  inline Edge *GetFirstEdgeInDir (GraphDir dir) const;
   /**
-   * Add predecessor edge
+   * \returns first successor edge
    */
-  virtual inline void AddPred (Edge *edge)
-  {
-    addEdgeInDir (edge, GRAPH_DIR_UP);
-  }
-
+  inline Edge *GetFirstSucc (void) const;
   /**
-   * Add successor edge
+   * \returns first predecessor edge
    */
-  virtual inline void addSucc( Edge *edge)
-  {
-    addEdgeInDir (edge, GRAPH_DIR_DOWN);
-  }
+  inline Edge *GetFirstPred (void) const;
   /**
-   *  Iteration through edges routines.
-   *
-   *  set iterator to beginning of edge list and return first edge
+   * \returns next node of a graph
    */
-  virtual inline Edge* firstEdgeInDir( GraphDir dir)
-  {
-      e_it[ dir ] = edges[ dir ];
-
-      if ( e_it[ dir] == NULL)
-      {
-          return NULL;
-      }
-      return e_it[ dir ]->data();
-  }
+  inline Node *GetNextNode (void) const;
   /**
-   * Advance iterator and return next edge in specified direction
-   * NOTE: If end of list is reached we return NULL for first time and fail if called once again
+   * \returns previous node of a graph
    */
-  virtual inline Edge* nextEdgeInDir( GraphDir dir)
-  {
-      e_it[ dir] = e_it[ dir]->next();
-      return (e_it[ dir] != NULL )? e_it[ dir]->data() : NULL;
-  }
+  inline Node *GetPrevNode (void) const;
   /**
-   * Return true if iterator of list points to one-after-last element
+   * Print node in dot format to stdout
    */
-  inline bool endOfEdgesInDir( GraphDir dir)
-  {
-      return e_it [ dir] == NULL;
-  }
+  virtual void DebugPrint (void) const;
 
+protected:
   /**
-   * Corresponding iterators for successors/predeccessors.
-   * NOTE: See firstEdgeInDir and other ...InDir routines for details
+   * We can't create nodes separately, do it through NewNode method of graph
    */
-  virtual inline Edge* firstSucc()
-  {
-      return firstEdgeInDir( GRAPH_DIR_DOWN);
-  }
-  virtual inline Edge* nextSucc()
-  {
-      return nextEdgeInDir( GRAPH_DIR_DOWN);
-  }
-  inline bool endOfSuccs()
-  {
-      return endOfEdgesInDir( GRAPH_DIR_DOWN);
-  }
-  virtual inline Edge* firstPred()
-  {
-      return firstEdgeInDir( GRAPH_DIR_UP);
-  }
-  virtual inline Edge* nextPred()
-  {
-      return nextEdgeInDir( GRAPH_DIR_UP);
-  }
-  inline bool endOfPreds()
-  {
-      return endOfEdgesInDir( GRAPH_DIR_UP);
-  }
+  Node (Graph *graph, GraphNum id);
   /**
-   * Deletion of edge in specified direction
+   * \brief write attributes and children of the node element
    */
-  void DeleteEdgeInDir (GraphDir dir, EdgeListItem* it);
+  virtual void WriteByXmlWriter (xmlTextWriterPtr writer);
   /**
-   * delete predecessor edge
+   * \brief read attributes and children of the node element
    */
-  inline void DeletePredecessor (EdgeListItem* it);
+  virtual void ReadByXml (xmlNode *node);
   /**
-   * \delete successor edge
+   * \brief write the record of the node in the binary format
    */
-  inline void DeleteSuccesor (EdgeListItem* it);
+  virtual void WriteByBinaryWriter (BinaryWriter &writer);
   /**
-   * \returns next node of a graph
+   * \brief read the record written by WriteByBinaryWriter
    */
-  inline Node* nextNode (void);
+  virtual void ReadByBinary (BinaryReader &reader);
+
+private:
+  /** Graph and Edge are closely connected classes by implementation */
+  friend class Graph;
+  friend class Edge;
+
   /**
-   * \returns previous node of a graph
+   * Add edge to node in specified direction
    */
-  inline Node* prevNode (void);
-
+  void AddEdgeInDir (Edge *edge, GraphDir dir);
+  /**
+   * Deletion of edge in specified direction
+   */
+  void DeleteEdgeInDir (Edge *edge, GraphDir dir);
 
+  GraphNum     m_id; // unique id is given by graph and cannot be modified
+  uint32_t     m_userId;
+  Graph        *m_graph;
+  NodeListItem m_graphItem; // item of graph's list
+  EdgeListItem *m_edges[GRAPH_DIRS_NUM]; // first items of the edge lists
+};
 
+GraphNum
+Node::GetId (void) const
+{
+  return m_id;
+}
 
+uint32_t
+Node::GetUserId (void) const
+{
+  return m_userId;
+}
 
-    int user_id;
-    /** Graph is closely connected class by implementation */
-    friend class Graph;
+void
+Node::SetUserId (uint32_t id)
+{
+  m_userId = id;
+}
 
-    /** Connection with inclusive graph */
-    int unique_id; // Unique id is given by graph and cannot be modified
-        protected:
-                Graph * graph;// Pointer to graph
-        private:
-    NodeListItem my_it;//Item of graph's list
+Graph *
+Node::GetGraph (void) const
+{
+  return m_graph;
+}
 
-    //Lists of edges and iterators for them
-    EdgeListItem *edges[ GRAPH_DIRS_NUM];
-    EdgeListItem *e_it[ GRAPH_DIRS_NUM];
+Edge *
+Node::GetFirstEdgeInDir (GraphDir dir) const
+{
+  return m_edges[dir] ? m_edges[dir]->GetData () : 0;
+}
 
-    inline NodeListItem* getGraphIt()
-    {
-        return &my_it;
-    }
-        inline void detachFromGraph()
-    {
-        my_it.detach();
-    }
-protected:
-        virtual void writeByXmlWriter( xmlTextWriterPtr writer);
-        virtual void readByXml (xmlNode * cur_node);
-protected:
+Edge *
+Node::GetFirstSucc (void) const
+{
+  return GetFirstEdgeInDir (GRAPH_DIR_DOWN);
+}
 
-    /** We can't create nodes separately, do it through NewNode method of graph */
-    Node( Graph *graph_p, int _id):
-         unique_id( _id), graph( graph_p), my_it()
-    {
-        edges[ GRAPH_DIR_UP] = NULL;
-        edges[ GRAPH_DIR_DOWN] = NULL;
-        e_it[ GRAPH_DIR_UP] = NULL;
-        e_it[ GRAPH_DIR_DOWN] = NULL;
-        my_it.setData( ( Node*)this);
-        setUserId( _id);
-    }
+Edge *
+Node::GetFirstPred (void) const
+{
+  return GetFirstEdgeInDir (GRAPH_DIR_UP);
+}
 
+Node *
+Node::GetNextNode (void) const
+{
+  NodeListItem *item = m_graphItem.GetNext ();
+  return item ? item->GetData () : 0;
+}
 
-};
+Node *
+Node::GetPrevNode (void) const
+{
+  NodeListItem *item = m_graphItem.GetPrev ();
+  return item ? item->GetData () : 0;
+}
 
 } // namespace graph
 
@@ -18,6 +18,8 @@
  * Author: Andrey Churin <aachurin@gmail.com>
  */
 
+#include "numeration.h"
+
 namespace graph {
 
 Numbered::Numbered ()
@@ -25,6 +27,7 @@ Numbered::Numbered ()
   for (NumIndex i = 0; i < MAX_NUMERATIONS; i++)
     {
       m_nums[i] = NUM_VALUE_CLEAN;
+      m_numbers[i] = NUMBER_NO_NUM;
     }
 }
 
@@ -32,58 +35,6 @@ Numbered::~Numbered ()
 {
 }
 
-bool
-Numbered::SetNumber (const Numeration &num, GraphNum value)
-{
-  if (value >= NUMBER_MAX)
-    {
-      throw NUM_ERROR_NUMBER_OUT_OF_RANGE;
-    }
-
-  m_nums[num.index] = num.value;
-  m_numbers[num.index] = value;
-
-//  if (m_nums[num.index] == num.value)
-//    {
-  return false;
-//    }
-//  return true;
-}
-
-GraphNum
-Numbered::GetNumber (const Numeration &num)
-{
-  if (m_nums[num.index] == num.value)
-    {
-      return m_numbers[num.index];
-    }
-  return NUMBER_NO_NUM;
-}
-
-bool
-Numbered::IsNumbered (const Numeration &num)
-{
-  return m_nums[num.index] == num.value;
-}
-
-bool
-Numbered::UnNumber (const Numeration &num)
-{
-  if (m_nums[num.index] == num.value)
-    {
-      m_nums[num.index] = NUM_VALUE_CLEAN;
-      return true;
-    }
-
-  return false;
-}
-
-void
-Numbered::Clear (NumIndex i)
-{
-  m_nums[i] = NUM_VALUE_CLEAN;
-}
-
 //// NumerationManager
 NumerationManager::NumerationManager ()
 {
@@ -105,8 +56,8 @@ NumerationManager::NewNum (void)
 {
   Numeration num;
   num.index = FindFreeIndex ();
-  m_isused[num.index] = true;
   num.value = FindNextFreeValue ();
+  m_isused[num.index] = true;
   m_nums[num.index] = num.value;
   return num;
 }
@@ -151,8 +102,10 @@ NumerationManager::IsValueBusy (NumValue val) const
 {
   for (NumIndex i = 0; i < MAX_NUMERATIONS; i++)
     {
-      if ( m_isused[i] && nums[i] == val)
-        return true;
+      if (m_isused[i] && m_nums[i] == val)
+        {
+          return true;
+        }
     }
   return false;
 }
@@ -160,30 +113,37 @@ NumerationManager::IsValueBusy (NumValue val) const
 NumValue
 NumerationManager::FindNextFreeValue (void)
 {
-  NumIndex i = 0;
   bool reached_limit = false;
-  NumValue res = last;
 
-  while (IsValueBusy (res))
+  // see MarkerManager::FindNextFreeValue
+  NumValue res = NextValue ();
+  while (res == NUM_VALUE_FIRST || IsValueBusy (res))
     {
-      if (res == NUM_VAL_LAST)
+      if (res == NUM_VALUE_FIRST)
         {
-          assert <NumErrorType> (!reached_limit, NUM_ERROR_OUT_OF_VALUES);
-          ClearNumerationsInObjects();
+          GraphAssert<NumErrorType> (!reached_limit, NUM_ERROR_OUT_OF_VALUES);
+          ClearNumerationsInObjects ();
           reached_limit = true;
+          if (!IsValueBusy (res))
+            {
+              break;
+            }
         }
-      res = NextValue();
+      res = NextValue ();
     }
   return res;
 }
 
 void
-NumerationManager::ClearUnusedNumerations (Numbered *numbered)
+NumerationManager::ClearUnusedNumerations (Numbered *numbered) const
 {
   for (NumIndex i = 0; i < MAX_NUMERATIONS; i++)
     {
-      if (!m_isused[i]) numbered->Clear (i);
+      if (!m_isused[i] || numbered->m_nums[i] != m_nums[i])
+        {
+          numbered->Clear (i);
+        }
     }
 }
 
-}; // namespace graph
+} // namespace graph
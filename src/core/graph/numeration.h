@@ -86,11 +86,11 @@ public:
   /**
    * \returns number in given numeration or NO_NUM if it was not numbered yet
    */
-  inline GraphNum GetNumber (const Numeration &num);
+  inline GraphNum GetNumber (const Numeration &num) const;
   /**
    * \returns true if node is numbered in this numeration
    */
-  inline bool IsNumbered (const Numeration &num);
+  inline bool IsNumbered (const Numeration &num) const;
   /**
    * \returns true if node has been numbered in this numeration and "unnumber" it
    */
@@ -101,12 +101,16 @@ public:
   inline void Clear (NumIndex i);
 
 private:
+  friend class NumerationManager;
   NumValue m_nums[MAX_NUMERATIONS];
   GraphNum m_numbers[MAX_NUMERATIONS];
 };
 
 /**
  * \brief Numeration manager
+ *
+ * The numbers are stored in the numbered objects, see NumerationTable
+ * for numbers kept apart from them.
  */
 class NumerationManager
 {
@@ -123,40 +127,86 @@ public:
   /**
    * \brief Free num
    */
-  inline void FreeNum (const Numeration& num);
+  void FreeNum (const Numeration& num);
 
 protected:
   /**
    * \brief Find free index
    */
-  inline NumIndex FindFreeIndex (void) const;
+  NumIndex FindFreeIndex (void) const;
   /**
    * \brief Increment num value
    */
-  inline NumValue NextValue (void);
+  NumValue NextValue (void);
   /**
    * \brief Check if this value is busy
    */
-  inline bool IsValueBusy (NumValue val) const;
+  bool IsValueBusy (NumValue val) const;
   /**
    * \brief Return next free value
    */
-  inline NumValue FindNextFreeValue (void);
+  NumValue FindNextFreeValue (void);
   /**
-   * \brief Clears unused markers in given object
+   * \brief Clears the values of freed numerations in given object
    */
-  inline void ClearUnusedNumerations (Numbered *numbered)
+  void ClearUnusedNumerations (Numbered *numbered) const;
   /**
-   * \brief MUST BE implemented in inhereted class
+   * \brief MUST BE implemented in inhereted class, calls
+   * ClearUnusedNumerations for every numbered object
    */
-  virtual void ClearNumerationsInObjects() = 0;
+  virtual void ClearNumerationsInObjects (void) = 0;
 
 private:
   NumValue m_nums[MAX_NUMERATIONS];
   bool m_isused[MAX_NUMERATIONS];
-  NumValue last;
+  NumValue m_last;
 };
 
-}; // namespace graph
+bool
+Numbered::SetNumber (const Numeration &num, GraphNum value)
+{
+  GraphAssert<NumErrorType> (value < NUMBER_MAX, NUM_ERROR_NUMBER_OUT_OF_RANGE);
+
+  bool numbered = m_nums[num.index] == num.value;
+  m_nums[num.index] = num.value;
+  m_numbers[num.index] = value;
+  return !numbered;
+}
+
+GraphNum
+Numbered::GetNumber (const Numeration &num) const
+{
+  if (m_nums[num.index] == num.value)
+    {
+      return m_numbers[num.index];
+    }
+  return NUMBER_NO_NUM;
+}
+
+bool
+Numbered::IsNumbered (const Numeration &num) const
+{
+  return m_nums[num.index] == num.value;
+}
+
+bool
+Numbered::UnNumber (const Numeration &num)
+{
+  if (m_nums[num.index] == num.value)
+    {
+      m_nums[num.index] = NUM_VALUE_CLEAN;
+      return true;
+    }
+
+  return false;
+}
+
+void
+Numbered::Clear (NumIndex i)
+{
+  m_nums[i] = NUM_VALUE_CLEAN;
+}
+
+} // namespace graph
 
 #endif /* NUMERATION_H */
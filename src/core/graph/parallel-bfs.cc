@@ -0,0 +1,213 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+#include "parallel-bfs.h"
+
+namespace graph {
+
+namespace {
+
+inline uint64_t
+GetBit (uint32_t node)
+{
+  return (uint64_t) 1 << (node & 63);
+}
+
+} // namespace
+
+ParallelBfs::ParallelBfs (const GraphSnapshot &snapshot)
+  : m_snapshot (snapshot),
+    m_frontierSize (0),
+    m_frontierEdges (0),
+    m_bottomUpLevels (0)
+{
+}
+
+uint32_t
+ParallelBfs::Run (uint32_t source, std::vector<uint32_t> &depth)
+{
+  uint32_t n = m_snapshot.GetNodeCount ();
+  // GetIndex of a node from another graph gives GRAPH_MAX_NODE_NUM
+  GraphAssert<GraphErrorType> (source < n, GRAPH_ERROR_FOREIGN_OBJECT);
+  uint32_t words = (n + 63) / 64;
+  depth.assign (n, GRAPH_MAX_NODE_NUM);
+  m_visited.assign (words, 0);
+  m_frontier.resize (n);
+  m_next.resize (n);
+  m_frontierBits.resize (words);
+  m_nextBits.resize (words);
+  m_bottomUpLevels = 0;
+
+  depth[source] = 0;
+  m_visited[source >> 6] |= GetBit (source);
+  m_frontier[0] = source;
+  m_frontierSize = 1;
+  m_frontierEdges = m_snapshot.GetDegree (source, GRAPH_DIR_DOWN);
+
+  uint64_t edgesToCheck = m_snapshot.GetEdgeCount () - m_frontierEdges; // successor edges of unvisited nodes
+  uint32_t reached = 1;
+  bool bottomUp = false;
+  for (uint32_t level = 0; m_frontierSize > 0; ++level)
+    {
+      if (!bottomUp && m_frontierEdges > edgesToCheck / ALPHA)
+        {
+          QueueToBits ();
+          bottomUp = true;
+        }
+      else if (bottomUp && m_frontierSize < n / BETA)
+        {
+          BitsToQueue ();
+          bottomUp = false;
+        }
+
+      if (bottomUp)
+        {
+          BottomUpStep (level, depth);
+          m_bottomUpLevels++;
+        }
+      else
+        {
+          TopDownStep (level, depth);
+        }
+      edgesToCheck -= m_frontierEdges;
+      reached += m_frontierSize;
+    }
+  return reached;
+}
+
+void
+ParallelBfs::Expand (uint32_t node, uint32_t level, std::vector<uint32_t> &depth,
+                     uint32_t &nextSize, uint64_t &nextEdges)
+{
+  const std::vector<uint32_t> &offsets = m_snapshot.GetOffsets (GRAPH_DIR_DOWN);
+  const std::vector<uint32_t> &targets = m_snapshot.GetTargets (GRAPH_DIR_DOWN);
+  for (uint32_t j = offsets[node]; j < offsets[node + 1]; ++j)
+    {
+      uint32_t succ = targets[j];
+      uint64_t bit = GetBit (succ);
+      // most successors are visited already, only claim the others with
+      // the locked instruction, the thread which sets the bit owns the node
+      if ((m_visited[succ >> 6] & bit) || (__sync_fetch_and_or (&m_visited[succ >> 6], bit) & bit))
+        {
+          continue;
+        }
+      depth[succ] = level + 1;
+      m_next[__sync_fetch_and_add (&nextSize, 1)] = succ;
+      nextEdges += offsets[succ + 1] - offsets[succ];
+    }
+}
+
+void
+ParallelBfs::TopDownStep (uint32_t level, std::vector<uint32_t> &depth)
+{
+  uint32_t nextSize = 0;
+  uint64_t nextEdges = 0;
+
+  // small frontiers of long paths don't pay for starting the threads
+  if (m_frontierSize <= 1024)
+    {
+      for (uint32_t i = 0; i < m_frontierSize; ++i)
+        {
+          Expand (m_frontier[i], level, depth, nextSize, nextEdges);
+        }
+    }
+  else
+    {
+#pragma omp parallel for schedule (dynamic, 64) reduction (+:nextEdges)
+      for (int32_t i = 0; i < (int32_t) m_frontierSize; ++i)
+        {
+          Expand (m_frontier[i], level, depth, nextSize, nextEdges);
+        }
+    }
+
+  m_frontier.swap (m_next);
+  m_frontierSize = nextSize;
+  m_frontierEdges = nextEdges;
+}
+
+void
+ParallelBfs::BottomUpStep (uint32_t level, std::vector<uint32_t> &depth)
+{
+  const std::vector<uint32_t> &offsets = m_snapshot.GetOffsets (GRAPH_DIR_UP);
+  const std::vector<uint32_t> &targets = m_snapshot.GetTargets (GRAPH_DIR_UP);
+  const std::vector<uint32_t> &succOffsets = m_snapshot.GetOffsets (GRAPH_DIR_DOWN);
+  uint32_t n = m_snapshot.GetNodeCount ();
+  uint32_t nextSize = 0;
+  uint64_t nextEdges = 0;
+
+  // every iteration owns the 64 nodes of one word, no atomics needed
+#pragma omp parallel for schedule (dynamic, 16) reduction (+:nextSize, nextEdges)
+  for (int32_t w = 0; w < (int32_t) m_visited.size (); ++w)
+    {
+      uint64_t next = 0;
+      uint32_t last = std::min (n, (uint32_t) (w + 1) * 64);
+      for (uint32_t node = w * 64; node < last; ++node)
+        {
+          if (m_visited[w] & GetBit (node))
+            {
+              continue;
+            }
+          for (uint32_t j = offsets[node]; j < offsets[node + 1]; ++j)
+            {
+              uint32_t pred = targets[j];
+              if (m_frontierBits[pred >> 6] & GetBit (pred))
+                {
+                  depth[node] = level + 1;
+                  next |= GetBit (node);
+                  nextSize++;
+                  nextEdges += succOffsets[node + 1] - succOffsets[node];
+                  break;
+                }
+            }
+        }
+      m_nextBits[w] = next;
+      m_visited[w] |= next;
+    }
+
+  m_frontierBits.swap (m_nextBits);
+  m_frontierSize = nextSize;
+  m_frontierEdges = nextEdges;
+}
+
+void
+ParallelBfs::QueueToBits (void)
+{
+  m_frontierBits.assign (m_frontierBits.size (), 0);
+  for (uint32_t i = 0; i < m_frontierSize; ++i)
+    {
+      m_frontierBits[m_frontier[i] >> 6] |= GetBit (m_frontier[i]);
+    }
+}
+
+void
+ParallelBfs::BitsToQueue (void)
+{
+  uint32_t size = 0;
+  for (uint32_t w = 0; w < m_frontierBits.size (); ++w)
+    {
+      for (uint64_t bits = m_frontierBits[w]; bits; bits &= bits - 1)
+        {
+          m_frontier[size++] = w * 64 + __builtin_ctzll (bits);
+        }
+    }
+}
+
+} // namespace graph
@@ -0,0 +1,102 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef PARALLEL_BFS_H
+#define PARALLEL_BFS_H
+
+#include <vector>
+#include "graph-common.h"
+#include "snapshot.h"
+
+namespace graph {
+
+/**
+ * \brief Parallel direction-optimizing breadth-first search over a
+ * GraphSnapshot
+ *
+ * Small frontiers are expanded top-down along successors. Once the
+ * frontier's edges outnumber a fraction of the edges of the unvisited
+ * nodes, every unvisited node instead looks for a predecessor in the
+ * frontier (bottom-up) and stops at the first one. Levels are processed
+ * in parallel with OpenMP when the library is built with it, and the
+ * visited nodes are kept in a bitset claimed atomically. Buffers are
+ * kept between runs, so one object serves many sources; use one object
+ * per thread.
+ */
+class ParallelBfs
+{
+public:
+  explicit ParallelBfs (const GraphSnapshot &snapshot);
+
+  /**
+   * \param source index of the start node in the snapshot, throws
+   * GRAPH_ERROR_FOREIGN_OBJECT if it is out of range
+   * \param depth filled with the number of edges from source to every
+   * node in the snapshot, GRAPH_MAX_NODE_NUM for unreachable nodes
+   * \returns number of reached nodes
+   */
+  uint32_t Run (uint32_t source, std::vector<uint32_t> &depth);
+  /**
+   * \returns number of bottom-up levels of the last run
+   */
+  inline uint32_t GetBottomUpLevels (void) const
+  {
+    return m_bottomUpLevels;
+  }
+
+  /**
+   * Switch to bottom-up when the frontier has more than 1 / ALPHA of the
+   * edges left to check, back to top-down when it has less than
+   * 1 / BETA of the nodes
+   */
+  static const uint32_t ALPHA = 14;
+  static const uint32_t BETA = 24;
+
+private:
+  /**
+   * \brief expand m_frontier into m_next along successors
+   */
+  void TopDownStep (uint32_t level, std::vector<uint32_t> &depth);
+  /**
+   * \brief claim the unvisited successors of node and append them to m_next
+   */
+  inline void Expand (uint32_t node, uint32_t level, std::vector<uint32_t> &depth,
+                      uint32_t &nextSize, uint64_t &nextEdges);
+  /**
+   * \brief find a predecessor in m_frontierBits for every unvisited node
+   */
+  void BottomUpStep (uint32_t level, std::vector<uint32_t> &depth);
+  void QueueToBits (void);
+  void BitsToQueue (void);
+
+  const GraphSnapshot   &m_snapshot;
+  std::vector<uint64_t> m_visited;
+  std::vector<uint32_t> m_frontier;
+  std::vector<uint32_t> m_next;
+  std::vector<uint64_t> m_frontierBits;
+  std::vector<uint64_t> m_nextBits;
+  uint32_t              m_frontierSize;
+  uint64_t              m_frontierEdges; // successor edges of the frontier
+  uint32_t              m_bottomUpLevels;
+};
+
+} // namespace graph
+
+#endif /* PARALLEL_BFS_H */
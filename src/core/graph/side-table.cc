@@ -0,0 +1,158 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include "graph.h"
+#include "side-table.h"
+
+namespace graph {
+
+namespace {
+
+/**
+ * \brief move slot to its next generation, clearing the stamps when the
+ * counter wraps around
+ */
+template <class T>
+void
+NextGeneration (T *slot)
+{
+  if (++slot->generation == 0)
+    {
+      slot->nodes.stamps.assign (slot->nodes.stamps.size (), 0);
+      slot->edges.stamps.assign (slot->edges.stamps.size (), 0);
+      slot->generation = 1;
+    }
+}
+
+/**
+ * \brief take a slot from the free ones or make a new one sized for the ids
+ */
+template <class T>
+T *
+GetSlot (std::vector<T *> &slots, std::vector<T *> &free, GraphNum nodeIds, GraphNum edgeIds)
+{
+  if (!free.empty ())
+    {
+      T *slot = free.back ();
+      free.pop_back ();
+      return slot;
+    }
+
+  T *slot = new T ();
+  slot->nodes.stamps.resize (nodeIds, 0);
+  slot->edges.stamps.resize (edgeIds, 0);
+  slots.push_back (slot);
+  return slot;
+}
+
+template <class T>
+void
+DeleteSlots (std::vector<T *> &slots)
+{
+  for (typename std::vector<T *>::const_iterator i = slots.begin (); i != slots.end (); ++i)
+    {
+      delete *i;
+    }
+  slots.clear ();
+}
+
+} // namespace
+
+//// MarkerTable
+
+SideMarker::Slot::Slot ()
+  : generation (0)
+{
+}
+
+MarkerTable::MarkerTable ()
+  : m_nodeIds (0),
+    m_edgeIds (0)
+{
+}
+
+MarkerTable::MarkerTable (const Graph &graph)
+  : m_nodeIds (graph.GetNodeIdLimit ()),
+    m_edgeIds (graph.GetEdgeIdLimit ())
+{
+}
+
+MarkerTable::~MarkerTable ()
+{
+  DeleteSlots (m_slots);
+}
+
+SideMarker
+MarkerTable::NewMarker (void)
+{
+  SideMarker marker;
+  marker.m_slot = GetSlot (m_slots, m_free, m_nodeIds, m_edgeIds);
+  NextGeneration (marker.m_slot);
+  marker.m_generation = marker.m_slot->generation;
+  return marker;
+}
+
+void
+MarkerTable::FreeMarker (const SideMarker &marker)
+{
+  m_free.push_back (marker.m_slot);
+}
+
+//// NumerationTable
+
+SideNumeration::Slot::Slot ()
+  : generation (0)
+{
+}
+
+NumerationTable::NumerationTable ()
+  : m_nodeIds (0),
+    m_edgeIds (0)
+{
+}
+
+NumerationTable::NumerationTable (const Graph &graph)
+  : m_nodeIds (graph.GetNodeIdLimit ()),
+    m_edgeIds (graph.GetEdgeIdLimit ())
+{
+}
+
+NumerationTable::~NumerationTable ()
+{
+  DeleteSlots (m_slots);
+}
+
+SideNumeration
+NumerationTable::NewNum (void)
+{
+  SideNumeration num;
+  num.m_slot = GetSlot (m_slots, m_free, m_nodeIds, m_edgeIds);
+  NextGeneration (num.m_slot);
+  num.m_generation = num.m_slot->generation;
+  return num;
+}
+
+void
+NumerationTable::FreeNum (const SideNumeration &num)
+{
+  m_free.push_back (num.m_slot);
+}
+
+} // namespace graph
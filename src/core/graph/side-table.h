@@ -0,0 +1,311 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef SIDE_TABLE_H
+#define SIDE_TABLE_H
+
+#include <vector>
+#include "graph-common.h"
+#include "numeration.h"
+#include "node.h"
+#include "edge.h"
+
+namespace graph {
+
+/**
+ * \brief Generation stamps of nodes or edges, indexed by their ids
+ *
+ * An object carries the mark of the current generation when its stamp
+ * equals it, so that all marks are cleared by moving to the next
+ * generation.
+ */
+struct SideStamps
+{
+  std::vector<uint32_t> stamps;
+
+  inline bool IsSet (GraphNum id, uint32_t generation) const
+  {
+    return id < stamps.size () && stamps[id] == generation;
+  }
+  /**
+   * \returns false if the stamp was already set
+   */
+  inline bool Set (GraphNum id, uint32_t generation)
+  {
+    if (id >= stamps.size ())
+      {
+        stamps.resize (id + 1, 0);
+      }
+    bool set = stamps[id] == generation;
+    stamps[id] = generation;
+    return !set;
+  }
+  /**
+   * \returns true if the stamp was set
+   */
+  inline bool Reset (GraphNum id, uint32_t generation)
+  {
+    if (!IsSet (id, generation))
+      {
+        return false;
+      }
+    stamps[id] = 0;
+    return true;
+  }
+};
+
+/**
+ * \brief Stamps and numbers of nodes or edges, indexed by their ids
+ */
+struct SideNumbers : public SideStamps
+{
+  std::vector<GraphNum> numbers;
+
+  inline GraphNum Get (GraphNum id, uint32_t generation) const
+  {
+    return IsSet (id, generation) ? numbers[id] : NUMBER_NO_NUM;
+  }
+  /**
+   * \returns false if a number was already set
+   */
+  inline bool Set (GraphNum id, uint32_t generation, GraphNum value)
+  {
+    GraphAssert<NumErrorType> (value < NUMBER_MAX, NUM_ERROR_NUMBER_OUT_OF_RANGE);
+    if (id >= numbers.size ())
+      {
+        numbers.resize (id + 1, NUMBER_NO_NUM);
+      }
+    numbers[id] = value;
+    return SideStamps::Set (id, generation);
+  }
+};
+
+/**
+ * \brief Marker whose marks are kept in a MarkerTable
+ *
+ * Same as Marked::Mark (marker) and friends, with the object as the
+ * argument. Markers are cheap handles, copies share the marks.
+ */
+class SideMarker
+{
+public:
+  inline bool Mark (const Node *node);
+  inline bool Mark (const Edge *edge);
+  inline bool IsMarked (const Node *node) const;
+  inline bool IsMarked (const Edge *edge) const;
+  inline bool Unmark (const Node *node);
+  inline bool Unmark (const Edge *edge);
+
+private:
+  friend class MarkerTable;
+  struct Slot
+  {
+    Slot ();
+    SideStamps nodes;
+    SideStamps edges;
+    uint32_t   generation;
+  };
+
+  Slot     *m_slot;
+  uint32_t m_generation;
+};
+
+/**
+ * \brief Marker manager keeping the marks apart from the objects
+ *
+ * Every marker owns arrays of stamps indexed by node and edge ids, which
+ * are recycled by freed markers and cleared by generation counters, so
+ * NewMarker never visits the objects. There is no limit on the number of
+ * markers in use, and marking doesn't touch the nodes and edges
+ * themselves.
+ */
+class MarkerTable
+{
+public:
+  MarkerTable ();
+  /**
+   * \brief table sized for the current ids of graph, it grows with the
+   * graph on demand
+   */
+  explicit MarkerTable (const Graph &graph);
+  ~MarkerTable ();
+
+  /**
+   * \brief Acquire new marker, no object is marked with it
+   */
+  SideMarker NewMarker (void);
+  /**
+   * \brief Free marker, its arrays serve the next new marker
+   */
+  void FreeMarker (const SideMarker &marker);
+
+private:
+  MarkerTable (const MarkerTable &);
+  MarkerTable &operator = (const MarkerTable &);
+
+  GraphNum                         m_nodeIds;
+  GraphNum                         m_edgeIds;
+  std::vector<SideMarker::Slot *>  m_slots;
+  std::vector<SideMarker::Slot *>  m_free;
+};
+
+/**
+ * \brief Numeration whose numbers are kept in a NumerationTable
+ *
+ * Same as Numbered::SetNumber (num, value) and friends, with the object
+ * as the argument
+ */
+class SideNumeration
+{
+public:
+  inline bool SetNumber (const Node *node, GraphNum value);
+  inline bool SetNumber (const Edge *edge, GraphNum value);
+  inline GraphNum GetNumber (const Node *node) const;
+  inline GraphNum GetNumber (const Edge *edge) const;
+  inline bool IsNumbered (const Node *node) const;
+  inline bool IsNumbered (const Edge *edge) const;
+  inline bool UnNumber (const Node *node);
+  inline bool UnNumber (const Edge *edge);
+
+private:
+  friend class NumerationTable;
+  struct Slot
+  {
+    Slot ();
+    SideNumbers nodes;
+    SideNumbers edges;
+    uint32_t    generation;
+  };
+
+  Slot     *m_slot;
+  uint32_t m_generation;
+};
+
+/**
+ * \brief Numeration manager keeping the numbers apart from the objects,
+ * see MarkerTable
+ */
+class NumerationTable
+{
+public:
+  NumerationTable ();
+  explicit NumerationTable (const Graph &graph);
+  ~NumerationTable ();
+
+  SideNumeration NewNum (void);
+  void FreeNum (const SideNumeration &num);
+
+private:
+  NumerationTable (const NumerationTable &);
+  NumerationTable &operator = (const NumerationTable &);
+
+  GraphNum                            m_nodeIds;
+  GraphNum                            m_edgeIds;
+  std::vector<SideNumeration::Slot *> m_slots;
+  std::vector<SideNumeration::Slot *> m_free;
+};
+
+bool
+SideMarker::Mark (const Node *node)
+{
+  return m_slot->nodes.Set (node->GetId (), m_generation);
+}
+
+bool
+SideMarker::Mark (const Edge *edge)
+{
+  return m_slot->edges.Set (edge->GetId (), m_generation);
+}
+
+bool
+SideMarker::IsMarked (const Node *node) const
+{
+  return m_slot->nodes.IsSet (node->GetId (), m_generation);
+}
+
+bool
+SideMarker::IsMarked (const Edge *edge) const
+{
+  return m_slot->edges.IsSet (edge->GetId (), m_generation);
+}
+
+bool
+SideMarker::Unmark (const Node *node)
+{
+  return m_slot->nodes.Reset (node->GetId (), m_generation);
+}
+
+bool
+SideMarker::Unmark (const Edge *edge)
+{
+  return m_slot->edges.Reset (edge->GetId (), m_generation);
+}
+
+bool
+SideNumeration::SetNumber (const Node *node, GraphNum value)
+{
+  return m_slot->nodes.Set (node->GetId (), m_generation, value);
+}
+
+bool
+SideNumeration::SetNumber (const Edge *edge, GraphNum value)
+{
+  return m_slot->edges.Set (edge->GetId (), m_generation, value);
+}
+
+GraphNum
+SideNumeration::GetNumber (const Node *node) const
+{
+  return m_slot->nodes.Get (node->GetId (), m_generation);
+}
+
+GraphNum
+SideNumeration::GetNumber (const Edge *edge) const
+{
+  return m_slot->edges.Get (edge->GetId (), m_generation);
+}
+
+bool
+SideNumeration::IsNumbered (const Node *node) const
+{
+  return m_slot->nodes.IsSet (node->GetId (), m_generation);
+}
+
+bool
+SideNumeration::IsNumbered (const Edge *edge) const
+{
+  return m_slot->edges.IsSet (edge->GetId (), m_generation);
+}
+
+bool
+SideNumeration::UnNumber (const Node *node)
+{
+  return m_slot->nodes.Reset (node->GetId (), m_generation);
+}
+
+bool
+SideNumeration::UnNumber (const Edge *edge)
+{
+  return m_slot->edges.Reset (edge->GetId (), m_generation);
+}
+
+} // namespace graph
+
+#endif /* SIDE_TABLE_H */
@@ -0,0 +1,173 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+#include <utility>
+#include "graph.h"
+#include "snapshot.h"
+
+namespace graph {
+
+GraphSnapshot::GraphSnapshot ()
+{
+  for (uint32_t dir = 0; dir < GRAPH_DIRS_NUM; ++dir)
+    {
+      m_offsets[dir].assign (1, 0);
+    }
+}
+
+GraphSnapshot::GraphSnapshot (const Graph &graph)
+{
+  Build (graph);
+}
+
+void
+GraphSnapshot::Build (const Graph &graph)
+{
+  m_nodes.clear ();
+  m_nodes.reserve (graph.GetNodeCount ());
+  GraphNum maxId = 0;
+  for (Node *node = graph.GetFirstNode (); node; node = node->GetNextNode ())
+    {
+      m_nodes.push_back (node);
+      maxId = std::max (maxId, node->GetId ());
+    }
+
+  m_indexById.assign (m_nodes.empty () ? 0 : maxId + 1, GRAPH_MAX_NODE_NUM);
+  for (uint32_t i = 0; i < m_nodes.size (); ++i)
+    {
+      m_indexById[m_nodes[i]->GetId ()] = i;
+    }
+
+  for (uint32_t d = 0; d < GRAPH_DIRS_NUM; ++d)
+    {
+      GraphDir dir = (GraphDir) d;
+      std::vector<uint32_t> &offsets = m_offsets[dir];
+      std::vector<uint32_t> &targets = m_targets[dir];
+      std::vector<Edge *> &edges = m_edges[dir];
+
+      offsets.resize (m_nodes.size () + 1);
+      targets.clear ();
+      targets.reserve (graph.GetEdgeCount ());
+      edges.clear ();
+      edges.reserve (graph.GetEdgeCount ());
+      for (uint32_t i = 0; i < m_nodes.size (); ++i)
+        {
+          offsets[i] = targets.size ();
+          for (Edge *edge = m_nodes[i]->GetFirstEdgeInDir (dir); edge; edge = edge->GetNextEdgeInDir (dir))
+            {
+              targets.push_back (m_indexById[edge->GetNode (dir)->GetId ()]);
+              edges.push_back (edge);
+            }
+        }
+      offsets[m_nodes.size ()] = targets.size ();
+    }
+}
+
+uint32_t
+GraphSnapshot::GetIndex (const Node *node) const
+{
+  GraphNum id = node->GetId ();
+  if (id >= m_indexById.size () || m_indexById[id] == GRAPH_MAX_NODE_NUM ||
+      m_nodes[m_indexById[id]] != node)
+    {
+      return GRAPH_MAX_NODE_NUM;
+    }
+  return m_indexById[id];
+}
+
+void
+GraphSnapshot::DFS (std::vector<uint32_t> &order) const
+{
+  const std::vector<uint32_t> &offsets = m_offsets[GRAPH_DIR_DOWN];
+  const std::vector<uint32_t> &targets = m_targets[GRAPH_DIR_DOWN];
+  std::vector<uint8_t> visited (m_nodes.size (), 0);
+
+  order.clear ();
+  order.reserve (m_nodes.size ());
+  // next and end position in targets of every node on the path
+  std::vector<std::pair<uint32_t, uint32_t> > stack;
+  for (uint32_t root = 0; root < m_nodes.size (); ++root)
+    {
+      if (visited[root])
+        {
+          continue;
+        }
+      visited[root] = 1;
+      order.push_back (root);
+      stack.push_back (std::make_pair (offsets[root], offsets[root + 1]));
+
+      while (!stack.empty ())
+        {
+          std::pair<uint32_t, uint32_t> &top = stack.back ();
+          if (top.first == top.second)
+            {
+              stack.pop_back ();
+              continue;
+            }
+
+          uint32_t succ = targets[top.first++];
+          if (visited[succ])
+            {
+              continue;
+            }
+          visited[succ] = 1;
+          order.push_back (succ);
+          stack.push_back (std::make_pair (offsets[succ], offsets[succ + 1]));
+        }
+    }
+}
+
+void
+GraphSnapshot::BFS (std::vector<uint32_t> &order) const
+{
+  const std::vector<uint32_t> &offsets = m_offsets[GRAPH_DIR_DOWN];
+  const std::vector<uint32_t> &targets = m_targets[GRAPH_DIR_DOWN];
+  std::vector<uint8_t> visited (m_nodes.size (), 0);
+
+  order.clear ();
+  order.reserve (m_nodes.size ());
+  for (uint32_t root = 0; root < m_nodes.size (); ++root)
+    {
+      if (visited[root])
+        {
+          continue;
+        }
+      visited[root] = 1;
+      order.push_back (root);
+
+      // the tail of the order is the queue
+      for (uint32_t head = order.size () - 1; head < order.size (); ++head)
+        {
+          uint32_t node = order[head];
+          for (uint32_t i = offsets[node]; i < offsets[node + 1]; ++i)
+            {
+              uint32_t succ = targets[i];
+              if (!visited[succ])
+                {
+                  visited[succ] = 1;
+                  order.push_back (succ);
+                }
+            }
+        }
+    }
+}
+
+} // namespace graph
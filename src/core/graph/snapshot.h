@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <vector>
+#include "graph-common.h"
+
+namespace graph {
+
+/**
+ * \brief Frozen compressed sparse row copy of the structure of a Graph
+ *
+ * Nodes are numbered by their position in the node list of the graph.
+ * The successors of node i are GetTargets (GRAPH_DIR_DOWN) in
+ * [GetOffsets (GRAPH_DIR_DOWN)[i], GetOffsets (GRAPH_DIR_DOWN)[i + 1]),
+ * in the order of the edge lists of the node, predecessors likewise with
+ * GRAPH_DIR_UP. Traversals over the snapshot read memory sequentially
+ * instead of following list items. The snapshot doesn't follow later
+ * changes of the graph, build it again after them.
+ */
+class GraphSnapshot
+{
+public:
+  GraphSnapshot ();
+  explicit GraphSnapshot (const Graph &graph);
+
+  /**
+   * \brief copy the structure of graph, dropping the previous one
+   */
+  void Build (const Graph &graph);
+
+  inline uint32_t GetNodeCount (void) const
+  {
+    return m_nodes.size ();
+  }
+  inline uint32_t GetEdgeCount (void) const
+  {
+    return m_targets[GRAPH_DIR_DOWN].size ();
+  }
+  /**
+   * \returns GetNodeCount () + 1 offsets into GetTargets (dir)
+   */
+  inline const std::vector<uint32_t> &GetOffsets (GraphDir dir) const
+  {
+    return m_offsets[dir];
+  }
+  /**
+   * \returns indices of the adjacent nodes in direction dir
+   */
+  inline const std::vector<uint32_t> &GetTargets (GraphDir dir) const
+  {
+    return m_targets[dir];
+  }
+  inline uint32_t GetDegree (uint32_t index, GraphDir dir) const
+  {
+    return m_offsets[dir][index + 1] - m_offsets[dir][index];
+  }
+  /**
+   * \returns node of the graph at index
+   */
+  inline Node *GetNode (uint32_t index) const
+  {
+    return m_nodes[index];
+  }
+  /**
+   * \returns edge of the graph at position i of GetTargets (dir)
+   */
+  inline Edge *GetEdge (uint32_t i, GraphDir dir) const
+  {
+    return m_edges[dir][i];
+  }
+  /**
+   * \returns index of node or GRAPH_MAX_NODE_NUM if it isn't in the snapshot
+   */
+  uint32_t GetIndex (const Node *node) const;
+
+  /**
+   * \brief nodes in depth-first order, same as Graph::DFS
+   * \param order filled with node indices in the order of the visit
+   */
+  void DFS (std::vector<uint32_t> &order) const;
+  /**
+   * \brief nodes in breadth-first order, same as Graph::BFS
+   * \param order filled with node indices in the order of the visit
+   */
+  void BFS (std::vector<uint32_t> &order) const;
+
+private:
+  std::vector<Node *>   m_nodes;
+  std::vector<uint32_t> m_indexById; // node index by Node::GetId ()
+  std::vector<uint32_t> m_offsets[GRAPH_DIRS_NUM];
+  std::vector<uint32_t> m_targets[GRAPH_DIRS_NUM];
+  std::vector<Edge *>   m_edges[GRAPH_DIRS_NUM];
+};
+
+} // namespace graph
+
+#endif /* SNAPSHOT_H */
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include "graph.h"
+#include "traversal.h"
+
+namespace graph {
+
+TraversalContext::TraversalContext (const Graph &graph)
+  : m_generation (0)
+{
+  m_visited.stamps.resize (graph.GetNodeIdLimit (), 0);
+  m_depth.resize (graph.GetNodeIdLimit ());
+  m_parent.resize (graph.GetNodeIdLimit ());
+}
+
+void
+TraversalContext::Start (void)
+{
+  if (++m_generation == 0)
+    {
+      m_visited.stamps.assign (m_visited.stamps.size (), 0);
+      m_generation = 1;
+    }
+  m_order.clear ();
+  m_stack.clear ();
+}
+
+uint32_t
+TraversalContext::BFS (const Node *source, GraphDir dir)
+{
+  Start ();
+  Visit (source, 0, 0);
+  for (uint32_t head = 0; head < m_order.size (); ++head)
+    {
+      const Node *node = m_order[head];
+      GraphNum depth = m_depth[node->GetId ()] + 1;
+      for (const Edge *edge = node->GetFirstEdgeInDir (dir); edge; edge = edge->GetNextEdgeInDir (dir))
+        {
+          Visit (edge->GetNode (dir), edge, depth);
+        }
+    }
+  return m_order.size ();
+}
+
+uint32_t
+TraversalContext::DFS (const Node *source, GraphDir dir)
+{
+  Start ();
+  Visit (source, 0, 0);
+  m_stack.push_back (source->GetFirstEdgeInDir (dir));
+  while (!m_stack.empty ())
+    {
+      const Edge *edge = m_stack.back ();
+      if (!edge)
+        {
+          m_stack.pop_back ();
+          continue;
+        }
+      m_stack.back () = edge->GetNextEdgeInDir (dir);
+
+      const Node *node = edge->GetNode (dir);
+      if (Visit (node, edge, m_stack.size ()))
+        {
+          m_stack.push_back (node->GetFirstEdgeInDir (dir));
+        }
+    }
+  return m_order.size ();
+}
+
+bool
+TraversalContext::IsReachable (const Node *source, const Node *target, GraphDir dir)
+{
+  Start ();
+  Visit (source, 0, 0);
+  for (uint32_t head = 0; head < m_order.size (); ++head)
+    {
+      const Node *node = m_order[head];
+      if (node == target)
+        {
+          return true;
+        }
+      GraphNum depth = m_depth[node->GetId ()] + 1;
+      for (const Edge *edge = node->GetFirstEdgeInDir (dir); edge; edge = edge->GetNextEdgeInDir (dir))
+        {
+          Visit (edge->GetNode (dir), edge, depth);
+        }
+    }
+  return false;
+}
+
+} // namespace graph
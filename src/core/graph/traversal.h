@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef TRAVERSAL_H
+#define TRAVERSAL_H
+
+#include <vector>
+#include "graph-common.h"
+#include "side-table.h"
+
+namespace graph {
+
+/**
+ * \brief State of traversals of a graph which is only read
+ *
+ * Markers and numerations of a Graph live in its nodes and are handed
+ * out without synchronization, so they serve one traversal at a time.
+ * A context keeps the visited state, depths, parents and work lists of
+ * its traversals to itself, indexed by node id. Any number of threads
+ * may traverse the same graph, each with its own context, as long as
+ * nobody changes the graph meanwhile. The state is cleared by a
+ * generation counter, so a context is cheap to reuse for the next query.
+ */
+class TraversalContext
+{
+public:
+  explicit TraversalContext (const Graph &graph);
+
+  /**
+   * \brief visit the nodes reachable from source in breadth-first order
+   * \param dir GRAPH_DIR_DOWN follows successors, GRAPH_DIR_UP predecessors
+   * \returns number of visited nodes
+   */
+  uint32_t BFS (const Node *source, GraphDir dir = GRAPH_DIR_DOWN);
+  /**
+   * \brief visit the nodes reachable from source in depth-first order
+   * \returns number of visited nodes
+   */
+  uint32_t DFS (const Node *source, GraphDir dir = GRAPH_DIR_DOWN);
+  /**
+   * \brief breadth-first search from source which stops at target
+   * \returns true if target is reachable, GetParent then leads back along
+   * a shortest path
+   */
+  bool IsReachable (const Node *source, const Node *target, GraphDir dir = GRAPH_DIR_DOWN);
+
+  /**
+   * \returns nodes visited by the last traversal in the order of the visit
+   */
+  inline const std::vector<const Node *> &GetOrder (void) const
+  {
+    return m_order;
+  }
+  inline bool IsVisited (const Node *node) const
+  {
+    return m_visited.IsSet (node->GetId (), m_generation);
+  }
+  /**
+   * \returns edges from the source to node in the last traversal or
+   * NUMBER_NO_NUM if it hasn't been visited
+   */
+  inline GraphNum GetDepth (const Node *node) const
+  {
+    return IsVisited (node) ? m_depth[node->GetId ()] : NUMBER_NO_NUM;
+  }
+  /**
+   * \returns edge by which node has been reached in the last traversal,
+   * 0 for the source and nodes which haven't been visited
+   */
+  inline const Edge *GetParent (const Node *node) const
+  {
+    return IsVisited (node) ? m_parent[node->GetId ()] : 0;
+  }
+
+private:
+  /**
+   * \brief clear the state of the last traversal
+   */
+  void Start (void);
+  /**
+   * \returns false if node has already been visited, visits it otherwise
+   */
+  inline bool Visit (const Node *node, const Edge *parent, GraphNum depth);
+
+  uint32_t                  m_generation;
+  SideStamps                m_visited;
+  std::vector<GraphNum>     m_depth;
+  std::vector<const Edge *> m_parent;
+  std::vector<const Node *> m_order; // also the queue of BFS
+  std::vector<const Edge *> m_stack; // next edge of every node on the DFS path
+};
+
+bool
+TraversalContext::Visit (const Node *node, const Edge *parent, GraphNum depth)
+{
+  GraphNum id = node->GetId ();
+  if (!m_visited.Set (id, m_generation))
+    {
+      return false;
+    }
+  if (id >= m_depth.size ())
+    {
+      m_depth.resize (m_visited.stamps.size ());
+      m_parent.resize (m_visited.stamps.size ());
+    }
+  m_depth[id] = depth;
+  m_parent[id] = parent;
+  m_order.push_back (node);
+  return true;
+}
+
+} // namespace graph
+
+#endif /* TRAVERSAL_H */
@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef XML_UTIL_H
+#define XML_UTIL_H
+
+#include <cstdlib>
+#include <string>
+#include <stdint.h>
+#include <libxml/tree.h>
+
+namespace graph {
+
+/**
+ * \param node element
+ * \param name attribute name
+ * \param value set to the attribute value if it is present
+ * \returns false if the element has no such attribute
+ */
+inline bool
+GetXmlProp (xmlNode *node, const char *name, std::string &value)
+{
+  xmlChar *prop = xmlGetProp (node, (const xmlChar *) name);
+  if (!prop)
+    {
+      return false;
+    }
+  value = (const char *) prop;
+  xmlFree (prop);
+  return true;
+}
+
+/**
+ * \param node element
+ * \param name attribute name
+ * \param value set to the attribute value if it is a number
+ * \returns false if the element has no such numeric attribute
+ */
+inline bool
+GetXmlProp (xmlNode *node, const char *name, uint32_t &value)
+{
+  std::string prop;
+  if (!GetXmlProp (node, name, prop) || prop.empty ())
+    {
+      return false;
+    }
+  char *end;
+  unsigned long number = strtoul (prop.c_str (), &end, 10);
+  if (*end)
+    {
+      return false;
+    }
+  value = number;
+  return true;
+}
+
+} // namespace graph
+
+#endif /* XML_UTIL_H */
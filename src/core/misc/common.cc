@@ -167,7 +167,6 @@ Edge::SetNodes (const Node &node1, const Node &node2)
   double dy = node2.y - node1.y;
   double dx = node2.x - node1.x;
   distance = std::sqrt (dy * dy + dx * dx);
-  angle = std::atan2 (dy, dx);
 }
 
 Edge::~Edge ()
@@ -175,20 +174,19 @@ Edge::~Edge ()
 }
 
 Packet::Packet ()
-  : edge (0)
+  : m_fbTx (0),
+    m_lbTx (0),
+    m_fbRx (0),
+    m_lbRx (0),
+    m_series (0)
 {
 }
 
-Packet::Packet (const Edge &e, uint32_t dir, double firstBitTx, double lastBitTx, double firstBitRx, double lastBitRx)
-  : edge (&e),
-    direction (dir),
-    fbTx (firstBitTx),
-    lbTx (lastBitTx),
-    fbRx (firstBitRx),
-    lbRx (lastBitRx)
-{
-}
-
-Packet::~Packet ()
+Packet::Packet (uint32_t link, uint32_t dir, double firstBitTx, double lastBitTx, double firstBitRx, double lastBitRx)
+  : m_fbTx (firstBitTx),
+    m_lbTx (lastBitTx - firstBitTx),
+    m_fbRx (firstBitRx - firstBitTx),
+    m_lbRx (lastBitRx - firstBitTx),
+    m_series (link * 2 + (dir ? 1 : 0))
 {
 }
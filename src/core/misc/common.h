@@ -120,23 +120,93 @@ public:
   const Node *n1;
   const Node *n2;
   double distance;
-  double angle;
 };
 
+/**
+ * \brief Packet hop record, 24 bytes and trivially copyable
+ *
+ * Only the first bit transmission time is absolute, the other times are
+ * single precision offsets from it, exact to about 1E-7 of the hop duration.
+ */
 class Packet
 {
 public:
   Packet ();
-  Packet (const Edge &e, uint32_t dir, double firstBitTx, double lastBitTx, double firstBitRx, double lastBitRx);
-  virtual ~Packet ();
+  /**
+   * \param link link index
+   * \param dir 0 - from n1 to n2
+   * \param firstBitTx
+   * \param lastBitTx
+   * \param firstBitRx
+   * \param lastBitRx
+   */
+  Packet (uint32_t link, uint32_t dir, double firstBitTx, double lastBitTx, double firstBitRx, double lastBitRx);
 
-public:
-  const Edge *edge;
-  uint32_t direction; // 0 - from n1 to n2
-  double fbTx;
-  double lbTx;
-  double fbRx;
-  double lbRx;
+  /**
+   * \returns link index
+   */
+  uint32_t GetLink (void) const;
+  /**
+   * \returns 0 - from n1 to n2
+   */
+  uint32_t GetDirection (void) const;
+  /**
+   * \returns link index * 2 + direction
+   */
+  uint32_t GetSeries (void) const;
+  double GetFirstBitTx (void) const;
+  double GetLastBitTx (void) const;
+  double GetFirstBitRx (void) const;
+  double GetLastBitRx (void) const;
+
+private:
+  double   m_fbTx;
+  float    m_lbTx; // relative to m_fbTx
+  float    m_fbRx; // relative to m_fbTx
+  float    m_lbRx; // relative to m_fbTx
+  uint32_t m_series; // link index * 2 + direction
 };
 
+inline uint32_t
+Packet::GetLink (void) const
+{
+  return m_series >> 1;
+}
+
+inline uint32_t
+Packet::GetDirection (void) const
+{
+  return m_series & 1;
+}
+
+inline uint32_t
+Packet::GetSeries (void) const
+{
+  return m_series;
+}
+
+inline double
+Packet::GetFirstBitTx (void) const
+{
+  return m_fbTx;
+}
+
+inline double
+Packet::GetLastBitTx (void) const
+{
+  return m_fbTx + m_lbTx;
+}
+
+inline double
+Packet::GetFirstBitRx (void) const
+{
+  return m_fbTx + m_fbRx;
+}
+
+inline double
+Packet::GetLastBitRx (void) const
+{
+  return m_fbTx + m_lbRx;
+}
+
 #endif /* COMMON_H */
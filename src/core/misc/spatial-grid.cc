@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "spatial-grid.h"
+
+// upper limit of grid columns and rows
+static const int32_t MAX_CELLS = 4096;
+
+SpatialGrid::SpatialGrid ()
+  : m_left (0),
+    m_top (0),
+    m_cellSize (1),
+    m_columns (1),
+    m_rows (1)
+{
+  m_offsets.assign (2, 0);
+}
+
+void
+SpatialGrid::Reset (double left, double top, double right, double bottom, uint32_t items)
+{
+  double width = std::max (right - left, 0.0);
+  double height = std::max (bottom - top, 0.0);
+  double extent = std::max (std::max (width, height), 1e-9);
+
+  // degenerate (e.g. linear) layouts still get square cells
+  width = std::max (width, extent * 1e-3);
+  height = std::max (height, extent * 1e-3);
+
+  m_left = left;
+  m_top = top;
+  m_cellSize = std::sqrt (width * height / std::max (items, (uint32_t)1));
+  m_cellSize = std::max (m_cellSize, extent / MAX_CELLS);
+  m_columns = std::min ((int32_t)(width / m_cellSize) + 1, MAX_CELLS);
+  m_rows = std::min ((int32_t)(height / m_cellSize) + 1, MAX_CELLS);
+
+  m_entries.clear ();
+  m_items.clear ();
+  m_offsets.assign (m_columns * m_rows + 1, 0);
+}
+
+int32_t
+SpatialGrid::GetColumn (double x) const
+{
+  double column = std::floor ((x - m_left) / m_cellSize);
+  return (int32_t)std::max (0.0, std::min (column, (double)(m_columns - 1)));
+}
+
+int32_t
+SpatialGrid::GetRow (double y) const
+{
+  double row = std::floor ((y - m_top) / m_cellSize);
+  return (int32_t)std::max (0.0, std::min (row, (double)(m_rows - 1)));
+}
+
+void
+SpatialGrid::AddCell (uint32_t item, int32_t column, int32_t row)
+{
+  m_entries.push_back (std::make_pair ((uint32_t)(row * m_columns + column), item));
+}
+
+void
+SpatialGrid::AddPoint (uint32_t item, double x, double y)
+{
+  AddCell (item, GetColumn (x), GetRow (y));
+}
+
+void
+SpatialGrid::AddSegment (uint32_t item, double x1, double y1, double x2, double y2)
+{
+  // walk the cells crossed by the segment (Amanatides & Woo)
+  double fx = (x1 - m_left) / m_cellSize;
+  double fy = (y1 - m_top) / m_cellSize;
+  double dx = (x2 - x1) / m_cellSize;
+  double dy = (y2 - y1) / m_cellSize;
+  int32_t column = GetColumn (x1);
+  int32_t row = GetRow (y1);
+  int32_t lastColumn = GetColumn (x2);
+  int32_t lastRow = GetRow (y2);
+  int32_t stepX = dx > 0 ? 1 : -1;
+  int32_t stepY = dy > 0 ? 1 : -1;
+  double infinity = std::numeric_limits<double>::infinity ();
+  double deltaX = dx != 0 ? std::fabs (1 / dx) : infinity;
+  double deltaY = dy != 0 ? std::fabs (1 / dy) : infinity;
+  double maxX = dx > 0 ? (std::floor (fx) + 1 - fx) * deltaX : (fx - std::floor (fx)) * deltaX;
+  double maxY = dy > 0 ? (std::floor (fy) + 1 - fy) * deltaY : (fy - std::floor (fy)) * deltaY;
+  if (dx == 0)
+    {
+      maxX = infinity;
+    }
+  if (dy == 0)
+    {
+      maxY = infinity;
+    }
+
+  int32_t steps = std::abs (lastColumn - column) + std::abs (lastRow - row);
+  AddCell (item, column, row);
+  for (int32_t i = 0; i < steps; ++i)
+    {
+      if ((maxX < maxY && column != lastColumn) || row == lastRow)
+        {
+          maxX += deltaX;
+          column += stepX;
+        }
+      else
+        {
+          maxY += deltaY;
+          row += stepY;
+        }
+      AddCell (item, column, row);
+    }
+}
+
+void
+SpatialGrid::Finalize (void)
+{
+  std::sort (m_entries.begin (), m_entries.end ());
+  m_entries.erase (std::unique (m_entries.begin (), m_entries.end ()), m_entries.end ());
+
+  m_items.resize (m_entries.size ());
+  for (uint32_t i = 0; i < m_entries.size (); ++i)
+    {
+      m_offsets[m_entries[i].first + 1]++;
+      m_items[i] = m_entries[i].second;
+    }
+  for (uint32_t i = 1; i < m_offsets.size (); ++i)
+    {
+      m_offsets[i] += m_offsets[i - 1];
+    }
+
+  EntryVector ().swap (m_entries);
+}
+
+void
+SpatialGrid::Query (double left, double top, double right, double bottom, std::vector<uint32_t> &items) const
+{
+  int32_t lastColumn = GetColumn (right);
+  int32_t lastRow = GetRow (bottom);
+  for (int32_t row = GetRow (top); row <= lastRow; ++row)
+    {
+      for (int32_t column = GetColumn (left); column <= lastColumn; ++column)
+        {
+          uint32_t cell = row * m_columns + column;
+          items.insert (items.end (), m_items.begin () + m_offsets[cell], m_items.begin () + m_offsets[cell + 1]);
+        }
+    }
+}
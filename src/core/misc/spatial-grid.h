@@ -0,0 +1,92 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <stdint.h>
+#include <vector>
+#include <utility>
+
+/**
+ * \brief Uniform grid of items (points and segments) for hit testing
+ *
+ * Items are added between Reset and Finalize, after that the grid
+ * answers which items may touch a box in time proportional to the
+ * number of cells covered and items found.
+ */
+class SpatialGrid
+{
+public:
+  SpatialGrid ();
+
+  /**
+   * \param left
+   * \param top
+   * \param right
+   * \param bottom area covered by the grid, items outside go to the border cells
+   * \param items expected number of items, about one item per cell
+   */
+  void Reset (double left, double top, double right, double bottom, uint32_t items);
+  /**
+   * \param item item index
+   * \param x
+   * \param y
+   */
+  void AddPoint (uint32_t item, double x, double y);
+  /**
+   * \param item item index
+   * \param x1
+   * \param y1
+   * \param x2
+   * \param y2 segment end points, the item is added to every cell the segment crosses
+   */
+  void AddSegment (uint32_t item, double x1, double y1, double x2, double y2);
+  /**
+   * \brief sort added items into cells
+   */
+  void Finalize (void);
+  /**
+   * \param left
+   * \param top
+   * \param right
+   * \param bottom query box
+   * \param items indices of items in cells touching the box are appended, may repeat
+   */
+  void Query (double left, double top, double right, double bottom, std::vector<uint32_t> &items) const;
+
+private:
+  int32_t GetColumn (double x) const;
+  int32_t GetRow (double y) const;
+  void AddCell (uint32_t item, int32_t column, int32_t row);
+
+  typedef std::vector<std::pair<uint32_t, uint32_t> > EntryVector;
+
+  double        m_left;
+  double        m_top;
+  double        m_cellSize;
+  int32_t       m_columns;
+  int32_t       m_rows;
+  EntryVector   m_entries; // (cell, item) pairs until Finalize
+  std::vector<uint32_t> m_offsets; // items of cell i are [m_offsets[i], m_offsets[i + 1])
+  std::vector<uint32_t> m_items;
+};
+
+#endif /* SPATIAL_GRID_H */
@@ -19,14 +19,27 @@
  */
 
 #include <math.h>
+#include <algorithm>
+#include <iomanip>
 
 #include "motion-manager.h"
 #include "error.h"
 
+// highest degradation level, low priority motions enter every n-th frame from level 2 on
+static const uint32_t MAX_DEGRADATION = 4;
+
 MotionManager::MotionManager ()
   : m_target (0),
     m_currFrame (1),
     m_prevFrame (0),
+    m_forced (false),
+    m_damaged (false),
+    m_hasMatrix (false),
+    m_profiling (false),
+    m_droppedFrames (0),
+    m_budget (0),
+    m_frameTime (0),
+    m_degradation (0),
     m_motionCount (0),
     m_rate (25)
 {
@@ -161,7 +174,45 @@ MotionManager::HandleMotionTimer (void)
       m_currFrame++;
     }
 
-  HandleInvalidate ();
+  Gdk::Region region;
+  if (m_damaged || !CollectDamage (region))
+    {
+      HandleInvalidate ();
+    }
+  else
+    {
+      if (!m_overlay.has_zero_area ())
+        {
+          region.union_with_rect (m_overlay);
+        }
+      HandleInvalidate (region);
+    }
+
+  m_damaged = false;
+  return true;
+}
+
+bool
+MotionManager::CollectDamage (Gdk::Region &region)
+{
+  if (!m_hasMatrix)
+    {
+      return false;
+    }
+
+  for (MotionList::iterator i = m_motions.begin (); i != m_motions.end (); ++i)
+    {
+      // motions which skip the next frame don't change
+      if ((*i)->m_started && (*i)->m_owedFrames + 1 < GetFrameInterval (*i))
+        {
+          continue;
+        }
+      if (!(*i)->GetDamage (m_matrix, m_rate, region))
+        {
+          return false;
+        }
+    }
+
   return true;
 }
 
@@ -183,6 +234,22 @@ MotionManager::HandleInvalidate ()
     }
 }
 
+void
+MotionManager::HandleInvalidate (Gdk::Region &region)
+{
+  if (m_target == 0 || region.empty ())
+    {
+      return;
+    }
+
+  Glib::RefPtr<Gdk::Window> win = m_target->get_window ();
+
+  if (win != 0)
+    {
+      win->invalidate_region (region, false);
+    }
+}
+
 void
 MotionManager::Invalidate (void)
 {
@@ -190,27 +257,74 @@ MotionManager::Invalidate (void)
     {
       HandleInvalidate ();
     }
+  else
+    {
+      m_damaged = true;
+    }
 }
 
 void
 MotionManager::Process (const Cairo::RefPtr<Cairo::Context> &context)
+{
+  Cairo::Matrix matrix;
+  context->get_matrix (matrix);
+  Advance (matrix);
+  Render (context);
+}
+
+bool
+MotionManager::Advance (const Cairo::Matrix &matrix)
 {
   MotionList::iterator i = m_motions.begin ();
+  bool entered = m_currFrame != m_prevFrame;
+  bool threadedEntered = false;
+  bool timing = IsTiming ();
+
+  m_matrix = matrix;
+  m_hasMatrix = true;
+  if (entered)
+    {
+      m_droppedFrames += m_currFrame - m_prevFrame - 1;
+      UpdateDegradation ();
+    }
 
   while (i != m_motions.end ())
     {
       const Glib::RefPtr<Motion> motion = *i;
 
-      if (motion->m_started && m_currFrame != m_prevFrame)
+      if (m_profiling && !motion->m_threaded)
         {
-          motion->EnterFrame (m_rate);
+          motion->m_drawTime = 0;
         }
 
-      if (motion->m_visual)
+      bool due = motion->m_started && entered && ++motion->m_owedFrames >= GetFrameInterval (motion);
+      // a threaded motion is changed only while the render thread doesn't draw it,
+      // otherwise the changes and owed frames wait for the next frame
+      bool locked = motion->m_threaded && motion->m_frameMutex.trylock ();
+
+      if (locked && motion->ApplyChanges ())
         {
-          context->save ();
-          motion->DrawFrame (context);
-          context->restore ();
+          threadedEntered = true;
+        }
+      if (due && (locked || !motion->m_threaded))
+        {
+          double start = timing ? m_clock.elapsed () : 0;
+          // enter the skipped frames as well, so that motion time doesn't drift
+          motion->EnterFrames (m_rate, motion->m_owedFrames);
+          motion->m_owedFrames = 0;
+          threadedEntered = threadedEntered || motion->m_threaded;
+          if (timing)
+            {
+              motion->m_enterTime = m_clock.elapsed () - start;
+            }
+        }
+      else if (due && timing)
+        {
+          motion->m_enterTime = 0;
+        }
+      if (locked)
+        {
+          motion->m_frameMutex.unlock ();
         }
 
       if (motion->m_finished)
@@ -230,4 +344,192 @@ MotionManager::Process (const Cairo::RefPtr<Cairo::Context> &context)
     }
 
   m_prevFrame = m_currFrame;
+  return threadedEntered;
+}
+
+void
+MotionManager::UpdateDegradation (void)
+{
+  if (m_budget <= 0)
+    {
+      return;
+    }
+
+  // Cost of the previous frame on each thread: the GTK thread enters frames
+  // and draws the other motions while the render thread draws the threaded
+  // ones, so their times overlap and are never added.
+  double cost = m_frameTime;
+  double renderCost = 0;
+  for (MotionList::const_iterator i = m_motions.begin (); i != m_motions.end (); ++i)
+    {
+      cost += (*i)->m_enterTime;
+      if ((*i)->m_threaded)
+        {
+          renderCost += (*i)->GetDrawTime ();
+        }
+    }
+
+  // step by one level per frame, with hysteresis to avoid flapping
+  uint32_t level = m_degradation;
+  if ((cost > m_budget || renderCost > m_budget) && level < MAX_DEGRADATION)
+    {
+      level++;
+    }
+  else if (cost < m_budget / 2 && renderCost < m_budget / 2 && level > 0)
+    {
+      level--;
+    }
+
+  if (level == m_degradation)
+    {
+      return;
+    }
+
+  m_degradation = level;
+  for (MotionList::iterator i = m_motions.begin (); i != m_motions.end (); ++i)
+    {
+      uint32_t degradation = 0;
+      if ((*i)->m_priority == Motion::PRIORITY_LOW)
+        {
+          degradation = level;
+        }
+      else if ((*i)->m_priority == Motion::PRIORITY_NORMAL && level == MAX_DEGRADATION)
+        {
+          degradation = 1;
+        }
+
+      if ((*i)->m_degradation != degradation)
+        {
+          (*i)->m_degradation = degradation;
+          (*i)->Degrade (degradation);
+        }
+    }
+}
+
+uint32_t
+MotionManager::GetFrameInterval (const Glib::RefPtr<Motion> &motion) const
+{
+  // level 1 only lowers quality, level n > 1 enters every n-th frame
+  return std::max (motion->m_degradation, 1u);
+}
+
+bool
+MotionManager::IsTiming (void) const
+{
+  return m_profiling || m_budget > 0;
+}
+
+void
+MotionManager::SetFrameBudget (double seconds)
+{
+  m_budget = seconds;
+  if (m_budget <= 0)
+    {
+      // drop back to full quality at once
+      m_degradation = 0;
+      for (MotionList::iterator i = m_motions.begin (); i != m_motions.end (); ++i)
+        {
+          if ((*i)->m_degradation != 0)
+            {
+              (*i)->m_degradation = 0;
+              (*i)->Degrade (0);
+            }
+        }
+    }
+}
+
+double
+MotionManager::GetFrameBudget (void) const
+{
+  return m_budget;
+}
+
+uint32_t
+MotionManager::GetDegradation (void) const
+{
+  return m_degradation;
+}
+
+void
+MotionManager::Render (const Cairo::RefPtr<Cairo::Context> &context) const
+{
+  for (MotionList::const_iterator i = m_motions.begin (); i != m_motions.end (); ++i)
+    {
+      if ((*i)->m_visual && !(*i)->m_threaded)
+        {
+          context->save ();
+          if (m_profiling)
+            {
+              double start = m_clock.elapsed ();
+              (*i)->DrawFrame (context);
+              Glib::Mutex::Lock lock (m_profileMutex);
+              (*i)->m_drawTime += m_clock.elapsed () - start;
+            }
+          else
+            {
+              (*i)->DrawFrame (context);
+            }
+          context->restore ();
+        }
+    }
+}
+
+bool
+MotionManager::Pick (double x, double y, double tolerance, Glib::ustring &info) const
+{
+  // threaded motions are drawn below the others
+  for (int threaded = 0; threaded < 2; ++threaded)
+    {
+      for (MotionList::const_reverse_iterator i = m_motions.rbegin (); i != m_motions.rend (); ++i)
+        {
+          if ((*i)->m_visual && (*i)->m_threaded == (threaded != 0) && (*i)->Pick (x, y, tolerance, info))
+            {
+              return true;
+            }
+        }
+    }
+  return false;
+}
+
+void
+MotionManager::SetProfiling (bool enable)
+{
+  m_profiling = enable;
+}
+
+bool
+MotionManager::IsProfiling (void) const
+{
+  return m_profiling;
+}
+
+uint32_t
+MotionManager::GetDroppedFrames (void) const
+{
+  return m_droppedFrames;
+}
+
+void
+MotionManager::GetStatistics (const Cairo::Matrix &matrix, int width, int height, Glib::ustring &text) const
+{
+  for (MotionList::const_iterator i = m_motions.begin (); i != m_motions.end (); ++i)
+    {
+      Glib::ustring name = (*i)->m_name.empty () ? "motion" : (*i)->m_name;
+      text += Glib::ustring::compose ("%1: enter %2 ms, draw %3 ms\n", name,
+        Glib::ustring::format (std::fixed, std::setprecision (2), (*i)->m_enterTime * 1000),
+        Glib::ustring::format (std::fixed, std::setprecision (2), (*i)->GetDrawTime () * 1000));
+      (*i)->GetStatistics (matrix, width, height, text);
+    }
+}
+
+void
+MotionManager::SetFrameTime (double seconds)
+{
+  m_frameTime = seconds;
+}
+
+void
+MotionManager::SetOverlay (const Gdk::Rectangle &rect)
+{
+  m_overlay = rect;
 }
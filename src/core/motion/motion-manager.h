@@ -66,13 +66,86 @@ public:
    * \brief process all motions
    */
   void Process (const Cairo::RefPtr<Cairo::Context> &context);
+  /**
+   * \brief enter new frame in started motions and drop finished ones
+   * \param matrix user to device transformation the frame is drawn with
+   * \returns true if a threaded motion has entered a new frame
+   *
+   * Threaded motions which are being drawn by the render thread skip the frame,
+   * like degraded ones, and catch up later.
+   */
+  bool Advance (const Cairo::Matrix &matrix);
+  /**
+   * \brief draw visual motions, except the threaded ones
+   *
+   * Doesn't change any motion state, so it may be called from several
+   * threads at once, each one with its own context.
+   */
+  void Render (const Cairo::RefPtr<Cairo::Context> &context) const;
+  /**
+   * \brief ask visual motions, topmost first, what is drawn at the point
+   * \returns true if a motion has been hit, info describes the hit
+   */
+  bool Pick (double x, double y, double tolerance, Glib::ustring &info) const;
+  /**
+   * \param enable measure the time motions spend in EnterFrame and DrawFrame
+   */
+  void SetProfiling (bool enable);
+  /**
+   * \returns true if motions are profiled
+   */
+  bool IsProfiling (void) const;
+  /**
+   * \param seconds time motions may spend in EnterFrame and DrawFrame per frame, 0 disables;
+   * the GTK thread and the render thread are held to it separately
+   *
+   * While frames exceed the budget low priority motions are degraded step by
+   * step, first through Motion::Degrade, then by entering only every n-th
+   * frame. Skipped frames are entered later, so motion time doesn't drift.
+   */
+  void SetFrameBudget (double seconds);
+  /**
+   * \param seconds time the target spent drawing the last frame on the GTK
+   * thread, counted against the frame budget
+   */
+  void SetFrameTime (double seconds);
+  /**
+   * \returns frame budget in seconds
+   */
+  double GetFrameBudget (void) const;
+  /**
+   * \returns current degradation level
+   */
+  uint32_t GetDegradation (void) const;
+  /**
+   * \returns number of timer ticks which didn't get a frame
+   */
+  uint32_t GetDroppedFrames (void) const;
+  /**
+   * \brief describe every motion for the frame statistics
+   * \param matrix user to device transformation
+   * \param width
+   * \param height target size
+   * \param text lines are appended to it
+   */
+  void GetStatistics (const Cairo::Matrix &matrix, int width, int height, Glib::ustring &text) const;
+  /**
+   * \param rect device area which is redrawn on every tick, e.g. a statistics overlay;
+   * an empty rectangle disables it
+   */
+  void SetOverlay (const Gdk::Rectangle &rect);
 
 private:
   void HandleInvalidate (void);
+  void HandleInvalidate (Gdk::Region &region);
+  bool CollectDamage (Gdk::Region &region);
   void HandleMotionState (const Motion *motion);
   void HandleMotionStart ();
   void HandleMotionStop (bool invalidate = true);
   bool HandleMotionTimer (void);
+  void UpdateDegradation (void);
+  uint32_t GetFrameInterval (const Glib::RefPtr<Motion> &motion) const;
+  bool IsTiming (void) const;
 
   typedef std::list<Glib::RefPtr<Motion> > MotionList;
 
@@ -81,6 +154,17 @@ private:
   uint32_t      m_prevFrame;
   uint32_t      m_rate;
   bool          m_forced;
+  bool          m_damaged; // whole target must be redrawn on the next tick
+  bool          m_hasMatrix;
+  Cairo::Matrix m_matrix; // transformation used by the last Process call
+  bool          m_profiling;
+  uint32_t      m_droppedFrames;
+  mutable Glib::Mutex m_profileMutex; // guards draw times of motions rendered by several threads while profiling
+  Gdk::Rectangle m_overlay;
+  Glib::Timer   m_clock; // runs since construction, read by profiling
+  double        m_budget;
+  double        m_frameTime; // GTK thread time of the last drawn frame
+  uint32_t      m_degradation;
   MotionList    m_motions;
   uint32_t      m_motionCount;
   sigc::connection m_motionTimer;
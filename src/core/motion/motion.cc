@@ -25,7 +25,14 @@
 Motion::Motion ()
   : m_started (false),
     m_visual (false),
-    m_finished (false)
+    m_finished (false),
+    m_threaded (false),
+    m_enterTime (0),
+    m_drawTime (0),
+    m_renderTime (0),
+    m_priority (PRIORITY_NORMAL),
+    m_degradation (0),
+    m_owedFrames (0)
 {
 }
 
@@ -56,6 +63,7 @@ Motion::Start (void)
         }
 
       m_started = true;
+      m_owedFrames = 0;
       m_signalState.emit (this);
     }
 }
@@ -81,6 +89,34 @@ Motion::EnterFrame (uint32_t rate)
   m_signalEnterFrame.emit ();
 }
 
+void
+Motion::EnterFrames (uint32_t rate, uint32_t count)
+{
+  for (; count > 0 && m_started; count--)
+    {
+      EnterFrame (rate);
+    }
+}
+
+bool
+Motion::GetDamage (const Cairo::Matrix &matrix, uint32_t rate, Gdk::Region &region)
+{
+  // stopped motions don't change, started ones may change anything
+  return !m_started;
+}
+
+bool
+Motion::Pick (double x, double y, double tolerance, Glib::ustring &info)
+{
+  return false;
+}
+
+bool
+Motion::ApplyChanges (void)
+{
+  return false;
+}
+
 bool
 Motion::IsStarted (void) const
 {
@@ -99,6 +135,68 @@ Motion::IsFinished (void) const
   return m_finished;
 }
 
+void
+Motion::SetThreaded (bool threaded)
+{
+  m_threaded = threaded;
+}
+
+bool
+Motion::IsThreaded (void) const
+{
+  return m_threaded;
+}
+
+void
+Motion::SetPriority (Priority priority)
+{
+  m_priority = priority;
+}
+
+Motion::Priority
+Motion::GetPriority (void) const
+{
+  return m_priority;
+}
+
+void
+Motion::Degrade (uint32_t level)
+{
+}
+
+void
+Motion::SetName (const Glib::ustring &name)
+{
+  m_name = name;
+}
+
+Glib::ustring
+Motion::GetName (void) const
+{
+  return m_name;
+}
+
+double
+Motion::GetEnterTime (void) const
+{
+  return m_enterTime;
+}
+
+double
+Motion::GetDrawTime (void) const
+{
+  if (m_threaded)
+    {
+      return g_atomic_int_get (&m_renderTime) / 1e6;
+    }
+  return m_drawTime;
+}
+
+void
+Motion::GetStatistics (const Cairo::Matrix &matrix, int width, int height, Glib::ustring &text) const
+{
+}
+
 void
 Motion::Capture (const sigc::slot<void, const Motion* > &slot)
 {
@@ -132,6 +230,7 @@ Motion::signal_enter_frame (void) const
 StaticMotion::StaticMotion ()
 {
   SetVisual (true);
+  SetPriority (PRIORITY_HIGH);
 }
 
 StaticMotion::~StaticMotion ()
@@ -216,7 +315,9 @@ ImageMotion::DrawFrame (const Cairo::RefPtr<Cairo::Context> &context)
 {
   context->save ();
   context->set_identity_matrix ();
-  context->set_source (m_surface, m_x, m_y);
+  // tile workers draw at once, a cairomm source would share the reference
+  // count of m_surface between them
+  cairo_set_source_surface (context->cobj (), m_surface->cobj (), m_x, m_y);
   context->rectangle (m_x, m_y, m_width, m_height);
   context->clip ();
   context->paint ();
@@ -231,6 +332,7 @@ Animation::Animation (sigc::slot<double, double> t, double duration)
     m_transition (t)
 {
   SetVisual (false);
+  SetPriority (PRIORITY_HIGH);
   Start ();
 }
 
@@ -241,6 +343,7 @@ Animation::Animation (sigc::slot<double, double> t, double duration, const sigc:
     m_transition (t)
 {
   SetVisual (false);
+  SetPriority (PRIORITY_HIGH);
   Start ();
 }
 
@@ -338,6 +441,7 @@ AnimationQueue::Create (const Glib::RefPtr<Animation> &a1, const Glib::RefPtr<An
 AnimationQueue::AnimationQueue ()
 {
   SetVisual (false);
+  SetPriority (PRIORITY_HIGH);
   Start ();
 }
 
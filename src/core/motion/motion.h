@@ -30,6 +30,19 @@
 class Motion : public Glib::Object
 {
 public:
+  /**
+   * \enum Scheduling priority, used when frames exceed the frame budget
+   */
+  enum Priority
+  {
+    /** degraded first: lower quality, then skipped frames */
+    PRIORITY_LOW,
+    /** degraded only when low priority motions don't bring frames into budget */
+    PRIORITY_NORMAL,
+    /** never degraded, e.g. interaction feedback */
+    PRIORITY_HIGH
+  };
+
   virtual ~Motion ();
   /**
    * \brief start animation
@@ -51,14 +64,93 @@ public:
    * \returns true if motion is visual
    */
   bool IsFinished (void) const;
+  /**
+   * \param threaded draw motion by the render thread instead of the GTK thread,
+   * must be set before the motion is added to a scene
+   */
+  void SetThreaded (bool threaded = true);
+  /**
+   * \returns true if motion is drawn by the render thread
+   */
+  bool IsThreaded (void) const;
+  /**
+   * \param priority scheduling priority
+   */
+  void SetPriority (Priority priority);
+  /**
+   * \returns scheduling priority
+   */
+  Priority GetPriority (void) const;
+  /**
+   * \param name name shown by the frame statistics
+   */
+  void SetName (const Glib::ustring &name);
+  /**
+   * \returns motion name
+   */
+  Glib::ustring GetName (void) const;
+  /**
+   * \returns seconds spent in the last EnterFrame, measured while the scene is profiled
+   */
+  double GetEnterTime (void) const;
+  /**
+   * \returns seconds spent drawing the last frame, measured while the scene is
+   * profiled; threaded motions always report the last frame of the render thread
+   */
+  double GetDrawTime (void) const;
+  /**
+   * \brief describe motion specific counters for the frame statistics
+   * \param matrix user to device transformation the frame is drawn with
+   * \param width
+   * \param height visible device area
+   * \param text lines are appended to it
+   */
+  virtual void GetStatistics (const Cairo::Matrix &matrix, int width, int height, Glib::ustring &text) const;
   /**
    * \brief new frame
    */
   virtual void EnterFrame (uint32_t rate);
+  /**
+   * \brief enter several frames at once, e.g. the ones skipped by the manager
+   * \param rate motion rate
+   * \param count number of frames
+   *
+   * The default implementation enters them one by one, motions whose state
+   * is a function of time may advance once instead.
+   */
+  virtual void EnterFrames (uint32_t rate, uint32_t count);
   /**
    * \brief redraw frame
+   *
+   * Must not change motion state, frames may be drawn by several threads at once.
+   * This includes the reference counts of cairomm objects kept by the motion,
+   * so their raw cairo objects are used instead, e.g. as sources.
    */
   virtual void DrawFrame (const Cairo::RefPtr<Cairo::Context> &context) = 0;
+  /**
+   * \brief report area that changes in the next frame
+   * \param matrix user to device transformation used to draw the motion
+   * \param rate motion rate
+   * \param region damaged rectangles in device space are added to it
+   * \returns false if damaged area is unknown and the whole target must be redrawn
+   */
+  virtual bool GetDamage (const Cairo::Matrix &matrix, uint32_t rate, Gdk::Region &region);
+  /**
+   * \brief find what is drawn at the point
+   * \param x
+   * \param y point in user coordinates
+   * \param tolerance hit distance in user coordinates
+   * \param info description of the hit object
+   * \returns true if something has been hit
+   */
+  virtual bool Pick (double x, double y, double tolerance, Glib::ustring &info);
+  /**
+   * \brief apply changes requested while the render thread was drawing the motion
+   * \returns true if the motion has changed and must be redrawn
+   *
+   * Called by the motion manager on the GTK thread with the frame mutex held.
+   */
+  virtual bool ApplyChanges (void);
 
   typedef sigc::signal<void, const Motion* > SignalMotionStateType;
   typedef sigc::signal<void> SignalEnterFrame;
@@ -76,6 +168,23 @@ protected:
    * \brief finish animataion
    */
   void Finish (void);
+  /**
+   * \brief called when the motion manager changes the degradation of the motion
+   * \param level 0 is full quality, higher levels should draw cheaper frames
+   *
+   * The manager skips frames of degraded motions by itself, the default
+   * implementation does nothing else. Called on the GTK thread without the
+   * frame mutex, threaded motions defer the change to ApplyChanges.
+   */
+  virtual void Degrade (uint32_t level);
+
+  /**
+   * \brief held while a frame of threaded motion is entered or drawn
+   *
+   * The GTK thread must only try to lock it, changes it can't apply at once
+   * are left to ApplyChanges.
+   */
+  Glib::RecMutex m_frameMutex;
 
 private:
   void Capture (const sigc::slot<void, const Motion* > &slot);
@@ -85,12 +194,21 @@ private:
   bool m_started;
   bool m_finished;
   bool m_visual;
+  bool m_threaded;
+  Glib::ustring m_name;
+  double m_enterTime;
+  double m_drawTime;
+  mutable volatile gint m_renderTime; // microseconds, set atomically by the render thread
+  Priority m_priority;
+  uint32_t m_degradation;
+  uint32_t m_owedFrames; // frames skipped by the manager and not entered yet
 
   sigc::connection m_connection;
   SignalMotionStateType m_signalState;
   SignalEnterFrame m_signalEnterFrame;
 
   friend class MotionManager;
+  friend class RenderThread;
 };
 
 /**
@@ -0,0 +1,233 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+
+#include "render-thread.h"
+
+static const uint32_t RECENT_FRAMES = 120;
+
+static bool
+IsSameMatrix (const Cairo::Matrix &m1, const Cairo::Matrix &m2)
+{
+  return m1.xx == m2.xx && m1.yx == m2.yx && m1.xy == m2.xy &&
+         m1.yy == m2.yy && m1.x0 == m2.x0 && m1.y0 == m2.y0;
+}
+
+RenderThread::RenderThread (TileRenderer *tiles)
+  : m_thread (0),
+    m_quit (false),
+    m_requested (false),
+    m_hasFrame (false),
+    m_width (0),
+    m_height (0),
+    m_tiles (tiles),
+    m_tileMotion (0)
+{
+  cairo_matrix_init_identity (&m_matrix);
+  cairo_matrix_init_identity (&m_frontMatrix);
+  m_thread = Glib::Thread::create (sigc::mem_fun (*this, &RenderThread::Run), true);
+}
+
+RenderThread::~RenderThread ()
+{
+  {
+    Glib::Mutex::Lock lock (m_mutex);
+    m_quit = true;
+    m_cond.signal ();
+  }
+
+  m_thread->join ();
+}
+
+void
+RenderThread::Add (const Glib::RefPtr<Motion> &motion)
+{
+  Glib::Mutex::Lock lock (m_mutex);
+  m_motions.push_back (motion);
+}
+
+void
+RenderThread::Remove (const Glib::RefPtr<Motion> &motion)
+{
+  Glib::Mutex::Lock lock (m_mutex);
+  m_motions.remove (motion);
+}
+
+void
+RenderThread::Request (const Cairo::Matrix &matrix, int width, int height, bool force)
+{
+  Glib::Mutex::Lock lock (m_mutex);
+
+  if (!force && width == m_width && height == m_height && IsSameMatrix (matrix, m_matrix))
+    {
+      return;
+    }
+
+  m_matrix = matrix;
+  m_width = width;
+  m_height = height;
+  m_requested = true;
+  m_cond.signal ();
+}
+
+void
+RenderThread::Blit (const Cairo::RefPtr<Cairo::Context> &context, const Cairo::Matrix &matrix)
+{
+  Glib::Mutex::Lock lock (m_mutex);
+
+  if (!m_hasFrame)
+    {
+      return;
+    }
+
+  // Map the frame from the transformation it has been drawn with to the
+  // current one, so that panning and zooming follow the input immediately.
+  Cairo::Matrix delta;
+  Cairo::Matrix inverse = m_frontMatrix;
+  if (cairo_matrix_invert (&inverse) != CAIRO_STATUS_SUCCESS)
+    {
+      return;
+    }
+  cairo_matrix_multiply (&delta, &inverse, &matrix);
+
+  context->save ();
+  context->transform (delta);
+  context->set_source (m_front, 0, 0);
+  context->paint ();
+  context->restore ();
+}
+
+void
+RenderThread::TakeFrames (std::deque<std::pair<double, double> > &frames)
+{
+  Glib::Mutex::Lock lock (m_mutex);
+  frames.insert (frames.end (), m_frames.begin (), m_frames.end ());
+  m_frames.clear ();
+}
+
+RenderThread::SignalFrameReadyType&
+RenderThread::signal_frame_ready (void)
+{
+  return m_signalFrameReady;
+}
+
+void
+RenderThread::Run (void)
+{
+  while (true)
+    {
+      MotionList motions;
+      Cairo::Matrix matrix;
+      int width, height;
+
+      {
+        Glib::Mutex::Lock lock (m_mutex);
+        while (!m_requested && !m_quit)
+          {
+            m_cond.wait (m_mutex);
+          }
+
+        if (m_quit)
+          {
+            return;
+          }
+
+        m_requested = false;
+        motions = m_motions;
+        matrix = m_matrix;
+        width = m_width;
+        height = m_height;
+      }
+
+      if (width <= 0 || height <= 0)
+        {
+          continue;
+        }
+
+      double start = m_clock.elapsed ();
+      DrawFrame (motions, matrix, width, height);
+
+      {
+        Glib::Mutex::Lock lock (m_mutex);
+        std::swap (m_front, m_back);
+        m_frontMatrix = matrix;
+        m_hasFrame = true;
+        m_frames.push_back (std::make_pair (start, m_clock.elapsed () - start));
+        if (m_frames.size () > RECENT_FRAMES)
+          {
+            m_frames.pop_front ();
+          }
+      }
+
+      m_signalFrameReady.emit ();
+    }
+}
+
+void
+RenderThread::DrawFrame (const MotionList &motions, const Cairo::Matrix &matrix, int width, int height)
+{
+  // The back buffer is never blitted, so it is drawn without holding the lock
+  if (!m_back || m_back->get_width () != width || m_back->get_height () != height)
+    {
+      m_back = Cairo::ImageSurface::create (Cairo::FORMAT_ARGB32, width, height);
+    }
+
+  Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (m_back);
+  context->set_operator (Cairo::OPERATOR_CLEAR);
+  context->paint ();
+  context->set_operator (Cairo::OPERATOR_OVER);
+  context->set_matrix (matrix);
+
+  // each motion is drawn over the previous ones, so that a tiled frame
+  // gets the same pixels as one drawn by a single context
+  bool tiled = m_tiles && m_tiles->IsTiled (width, height);
+  m_tileMatrix = matrix;
+  for (MotionList::const_iterator i = motions.begin (); i != motions.end (); ++i)
+    {
+      if ((*i)->IsVisual ())
+        {
+          Glib::RecMutex::Lock lock ((*i)->m_frameMutex);
+          Glib::Timer timer;
+          if (tiled)
+            {
+              m_tileMotion = (*i).operator-> ();
+              m_tiles->Render (m_back, 0, sigc::mem_fun (*this, &RenderThread::DrawTile));
+            }
+          else
+            {
+              context->save ();
+              (*i)->DrawFrame (context);
+              context->restore ();
+            }
+          // read by the GTK thread without the frame mutex
+          g_atomic_int_set (&(*i)->m_renderTime, (gint)(timer.elapsed () * 1e6));
+        }
+    }
+
+  m_back->flush ();
+}
+
+void
+RenderThread::DrawTile (const Cairo::RefPtr<Cairo::Context> &context)
+{
+  context->set_matrix (m_tileMatrix);
+  m_tileMotion->DrawFrame (context);
+}
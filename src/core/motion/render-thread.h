@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include <stdint.h>
+#include <list>
+#include <deque>
+#include <gtkmm.h>
+
+#include "motion.h"
+#include "tile-renderer.h"
+
+/**
+ * \brief Draws threaded motions into a double-buffered image surface
+ *
+ * The GTK thread requests frames and blits the latest completed one, so
+ * heavy frames never stall input handling. Motions are drawn while their
+ * frame mutex is held, which makes the GTK thread skip their EnterFrame.
+ * Large frames are split into tiles drawn by the workers of a TileRenderer.
+ */
+class RenderThread
+{
+public:
+  /**
+   * \param tiles renderer of large frames, may be shared with other threads
+   */
+  RenderThread (TileRenderer *tiles);
+  virtual ~RenderThread ();
+  /**
+   * \param motion threaded motion
+   */
+  void Add (const Glib::RefPtr<Motion> &motion);
+  /**
+   * \param motion threaded motion
+   */
+  void Remove (const Glib::RefPtr<Motion> &motion);
+  /**
+   * \brief request a new frame, returns immediately
+   * \param matrix user to device transformation
+   * \param width frame width
+   * \param height frame height
+   * \param force redraw even if transformation and size didn't change
+   */
+  void Request (const Cairo::Matrix &matrix, int width, int height, bool force);
+  /**
+   * \brief paint the latest completed frame
+   * \param context target context with identity transformation
+   * \param matrix current user to device transformation, the frame is
+   * transformed to it if it has been drawn with a different one
+   */
+  void Blit (const Cairo::RefPtr<Cairo::Context> &context, const Cairo::Matrix &matrix);
+  /**
+   * \brief move start and duration of the frames completed since the last call
+   * \param frames seconds on the clock of the render thread, appended to it
+   */
+  void TakeFrames (std::deque<std::pair<double, double> > &frames);
+
+  typedef Glib::Dispatcher SignalFrameReadyType;
+  /**
+   * \brief emitted in the GTK thread when a new frame is completed
+   */
+  SignalFrameReadyType& signal_frame_ready (void);
+
+private:
+  typedef std::list<Glib::RefPtr<Motion> > MotionList;
+
+  void Run (void);
+  void DrawFrame (const MotionList &motions, const Cairo::Matrix &matrix, int width, int height);
+  void DrawTile (const Cairo::RefPtr<Cairo::Context> &context);
+
+  Glib::Thread *m_thread;
+  Glib::Mutex   m_mutex; // guards everything below
+  Glib::Cond    m_cond;
+  bool          m_quit;
+  bool          m_requested;
+  bool          m_hasFrame;
+  MotionList    m_motions;
+  Cairo::Matrix m_matrix; // last requested transformation
+  int           m_width;
+  int           m_height;
+  Cairo::RefPtr<Cairo::ImageSurface> m_front;
+  Cairo::RefPtr<Cairo::ImageSurface> m_back;
+  Cairo::Matrix m_frontMatrix; // transformation the front frame has been drawn with
+  std::deque<std::pair<double, double> > m_frames; // recent completed frames
+  Glib::Timer   m_clock;
+  SignalFrameReadyType m_signalFrameReady;
+  TileRenderer *m_tiles;
+  Motion       *m_tileMotion; // motion the tiles are drawn for, render thread only
+  Cairo::Matrix m_tileMatrix;
+};
+
+#endif /* RENDER_THREAD_H */
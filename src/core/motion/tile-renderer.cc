@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+
+#include "tile-renderer.h"
+
+// frames smaller than this are rasterized by one thread
+static const int TILED_MIN_AREA = 1920 * 1080;
+static const int TILE_SIZE = 256;
+
+TileRenderer::TileRenderer ()
+  : m_pool (0),
+    m_threads (1)
+{
+  if (Glib::thread_supported ())
+    {
+      m_pool = new Glib::ThreadPool (1);
+    }
+}
+
+TileRenderer::~TileRenderer ()
+{
+  delete m_pool;
+}
+
+void
+TileRenderer::SetThreads (uint32_t threads)
+{
+  threads = m_pool && threads > 1 ? threads : 1;
+  if (m_pool)
+    {
+      m_pool->set_max_threads (threads);
+    }
+  g_atomic_int_set (&m_threads, threads);
+}
+
+uint32_t
+TileRenderer::GetThreads (void) const
+{
+  return g_atomic_int_get (&m_threads);
+}
+
+bool
+TileRenderer::IsTiled (int width, int height) const
+{
+  return GetThreads () > 1 && width * height >= TILED_MIN_AREA;
+}
+
+void
+TileRenderer::Render (const Cairo::RefPtr<Cairo::ImageSurface> &surface, const GdkRegion *region, const DrawSlot &draw)
+{
+  Cairo::Format format = surface->get_format ();
+  if (format != Cairo::FORMAT_RGB24 && format != Cairo::FORMAT_ARGB32)
+    {
+      return;
+    }
+
+  surface->flush ();
+  unsigned char *data = surface->get_data ();
+  int stride = surface->get_stride ();
+  int width = surface->get_width ();
+  int height = surface->get_height ();
+
+  Batch batch;
+  batch.draw = &draw;
+  for (int y = 0; y < height; y += TILE_SIZE)
+    {
+      for (int x = 0; x < width; x += TILE_SIZE)
+        {
+          GdkRectangle rect = {x, y, std::min (TILE_SIZE, width - x), std::min (TILE_SIZE, height - y)};
+          if (region && gdk_region_rect_in (region, &rect) == GDK_OVERLAP_RECTANGLE_OUT)
+            {
+              continue;
+            }
+
+          // 4 bytes per pixel in both formats; the device offset places the
+          // tile at its position in the frame
+          cairo_surface_t *tile = cairo_image_surface_create_for_data (data + y * stride + x * 4,
+            (cairo_format_t) format, rect.width, rect.height, stride);
+          cairo_surface_set_device_offset (tile, -x, -y);
+          batch.tiles.push_back (tile);
+        }
+    }
+
+  batch.pending = batch.tiles.size ();
+  for (uint32_t i = 0; i < batch.tiles.size (); ++i)
+    {
+      if (m_pool)
+        {
+          m_pool->push (sigc::bind (sigc::ptr_fun (&TileRenderer::RenderTile), &batch, i));
+        }
+      else
+        {
+          RenderTile (&batch, i);
+        }
+    }
+
+  {
+    Glib::Mutex::Lock lock (batch.mutex);
+    while (batch.pending > 0)
+      {
+        batch.cond.wait (batch.mutex);
+      }
+  }
+
+  for (uint32_t i = 0; i < batch.tiles.size (); ++i)
+    {
+      cairo_surface_destroy (batch.tiles[i]);
+    }
+  surface->mark_dirty ();
+}
+
+void
+TileRenderer::RenderTile (Batch *batch, uint32_t index)
+{
+  cairo_surface_t *tile = batch->tiles[index];
+  {
+    // the context is created and released by this worker only
+    Cairo::RefPtr<Cairo::Context> context (new Cairo::Context (cairo_create (tile), true));
+    (*batch->draw) (context);
+  }
+  cairo_surface_flush (tile);
+
+  Glib::Mutex::Lock lock (batch->mutex);
+  if (--batch->pending == 0)
+    {
+      batch->cond.signal ();
+    }
+}
@@ -0,0 +1,84 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef TILE_RENDERER_H
+#define TILE_RENDERER_H
+
+#include <stdint.h>
+#include <vector>
+#include <gtkmm.h>
+
+/**
+ * \brief Rasterizes large image surfaces in tiles on a thread pool
+ *
+ * Every tile is a cairo surface over the pixels of the target, offset so
+ * that it samples exactly the pixels a single context would draw. Workers
+ * get raw cairo surfaces and a slot owned by the caller, so no cairomm
+ * reference count is shared between threads. Render may be called from
+ * several threads at once.
+ */
+class TileRenderer
+{
+public:
+  typedef sigc::slot<void, const Cairo::RefPtr<Cairo::Context>& > DrawSlot;
+
+  TileRenderer ();
+  virtual ~TileRenderer ();
+  /**
+   * \param threads number of threads rasterizing large frames, 1 disables tiling
+   */
+  void SetThreads (uint32_t threads);
+  /**
+   * \returns number of rendering threads
+   */
+  uint32_t GetThreads (void) const;
+  /**
+   * \returns true if a frame of this size is worth splitting into tiles
+   */
+  bool IsTiled (int width, int height) const;
+  /**
+   * \brief draw the tiles of surface which intersect region
+   * \param surface RGB24 or ARGB32 target, owned by the calling thread
+   * \param region device area to draw, 0 means the whole surface
+   * \param draw called for every tile by a worker, with a context whose
+   * clip is the tile; must not change any state shared between tiles
+   */
+  void Render (const Cairo::RefPtr<Cairo::ImageSurface> &surface, const GdkRegion *region, const DrawSlot &draw);
+
+private:
+  /**
+   * \brief tiles of one Render call
+   */
+  struct Batch
+  {
+    const DrawSlot *draw;
+    std::vector<cairo_surface_t *> tiles;
+    Glib::Mutex mutex;
+    Glib::Cond  cond;
+    uint32_t    pending;
+  };
+
+  static void RenderTile (Batch *batch, uint32_t index);
+
+  Glib::ThreadPool *m_pool;
+  volatile gint m_threads;
+};
+
+#endif /* TILE_RENDERER_H */
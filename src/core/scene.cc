@@ -19,10 +19,19 @@
  */
 
 #include <math.h>
+#include <unistd.h>
+#include <algorithm>
+#include <iomanip>
+#include <vector>
 
 #include "scene.h"
 #include "error.h"
 
+// number of recent frames the statistics are computed from
+static const uint32_t STATISTICS_FRAMES = 120;
+// hit distance of hover picking, in pixels
+static const double PICK_TOLERANCE = 4.0;
+
 Scene::Scene ()
   : m_zoom (1),
     m_rotation (0),
@@ -32,10 +41,19 @@ Scene::Scene ()
     m_centerY (0),
     m_borderWidth (1),
     m_borderColor (0.75, 0.75, 0.75, 1),
-    m_motionType (MOTION_NONE)
+    m_motionType (MOTION_NONE),
+    m_renderThread (0),
+    m_renderDirty (true),
+    m_statistics (false)
 {
   m_manager.SetTarget (this);
 
+  long cpus = sysconf (_SC_NPROCESSORS_ONLN);
+  if (Glib::thread_supported () && cpus > 1)
+    {
+      SetRenderThreads (cpus);
+    }
+
   set_events (Gdk::SCROLL_MASK | Gdk::BUTTON_PRESS_MASK | Gdk::BUTTON_RELEASE_MASK | Gdk::BUTTON_MOTION_MASK);
   signal_scroll_event ().connect (sigc::mem_fun (*this, &Scene::HandleScroll));
   signal_button_press_event ().connect (sigc::mem_fun (*this, &Scene::HandleButtonPress));
@@ -43,11 +61,15 @@ Scene::Scene ()
 
   signal_expose_event ().connect (sigc::mem_fun (*this, &Scene::HandleExpose));
 
+  set_has_tooltip (true);
+  signal_query_tooltip ().connect (sigc::mem_fun (*this, &Scene::HandleQueryTooltip));
+
 }
 
 Scene::~Scene ()
 {
   m_manager.SetTarget (0);
+  delete m_renderThread;
 }
 
 void
@@ -154,6 +176,49 @@ Scene::GetRate (void) const
   return m_manager.GetRate ();
 }
 
+void
+Scene::SetRenderThreads (uint32_t threads)
+{
+  m_tileRenderer.SetThreads (threads);
+}
+
+uint32_t
+Scene::GetRenderThreads (void) const
+{
+  return m_tileRenderer.GetThreads ();
+}
+
+void
+Scene::SetStatistics (bool enable)
+{
+  m_statistics = enable;
+  m_frames.clear ();
+  m_manager.SetProfiling (enable);
+  if (!enable)
+    {
+      m_manager.SetOverlay (Gdk::Rectangle ());
+    }
+  Invalidate ();
+}
+
+bool
+Scene::IsStatistics (void) const
+{
+  return m_statistics;
+}
+
+void
+Scene::SetFrameBudget (double seconds)
+{
+  m_manager.SetFrameBudget (seconds);
+}
+
+double
+Scene::GetFrameBudget (void) const
+{
+  return m_manager.GetFrameBudget ();
+}
+
 void
 Scene::ForceMotion (bool force)
 {
@@ -163,18 +228,36 @@ Scene::ForceMotion (bool force)
 void
 Scene::AddMotion (const Glib::RefPtr<Motion> &motion)
 {
+  if (motion->IsThreaded ())
+    {
+      if (m_renderThread == 0)
+        {
+          m_renderThread = new RenderThread (&m_tileRenderer);
+          m_renderThread->signal_frame_ready ().connect (sigc::mem_fun (*this, &Scene::queue_draw));
+        }
+      m_renderThread->Add (motion);
+      m_renderDirty = true;
+    }
+
   m_manager.Add (motion);
 }
 
 void
 Scene::RemoveMotion (const Glib::RefPtr<Motion> &motion)
 {
+  if (m_renderThread != 0)
+    {
+      m_renderThread->Remove (motion);
+      m_renderDirty = true;
+    }
+
   m_manager.Remove (motion);
 }
 
 void
 Scene::Invalidate (void)
 {
+  m_renderDirty = true;
   m_manager.Invalidate ();
 }
 
@@ -203,17 +286,37 @@ Scene::GetSceneViewport (uint32_t padding) const
   return rect;
 }
 
-void
-Scene::ApplyTransformation (const Cairo::RefPtr<Cairo::Context> &context)
+Cairo::Matrix
+Scene::GetTransformation (void) const
 {
   double sx, sy;
   double scale = m_scale * m_zoom;
   Gtk::Allocation allocation = get_allocation ();
+  Cairo::Matrix matrix;
 
-  context->scale (scale, scale);
+  cairo_matrix_init_scale (&matrix, scale, scale);
   GetSceneCoords (m_centerX, m_centerY, allocation.get_width (), allocation.get_height (), sx, sy);
-  context->translate (sx, sy);
-  context->rotate (m_rotation);
+  cairo_matrix_translate (&matrix, sx, sy);
+  cairo_matrix_rotate (&matrix, m_rotation);
+  return matrix;
+}
+
+void
+Scene::GetUserCoords (double x, double y, double &ux, double &uy) const
+{
+  Cairo::Matrix matrix = GetTransformation ();
+  ux = x;
+  uy = y;
+  if (cairo_matrix_invert (&matrix) == CAIRO_STATUS_SUCCESS)
+    {
+      cairo_matrix_transform_point (&matrix, &ux, &uy);
+    }
+}
+
+void
+Scene::ApplyTransformation (const Cairo::RefPtr<Cairo::Context> &context)
+{
+  context->transform (GetTransformation ());
 }
 
 Scene::SignalZoomChangeType
@@ -248,10 +351,56 @@ Scene::HandleExpose (GdkEventExpose* event)
 
   if (event)
     {
-      context->rectangle (event->area.x, event->area.y, event->area.width, event->area.height);
+      // clip to the damaged region only, not to its bounding box
+      gdk_cairo_region (context->cobj (), event->region);
       context->clip();
     }
 
+  double start = m_clock.elapsed ();
+  Gtk::Allocation allocation = get_allocation ();
+  if (m_renderThread != 0)
+    {
+      RenderThreaded (context);
+    }
+  else if (event && m_tileRenderer.IsTiled (allocation.get_width (), allocation.get_height ()))
+    {
+      RenderTiled (context, event);
+    }
+  else
+    {
+      Render (context);
+    }
+
+  double duration = m_clock.elapsed () - start;
+  m_manager.SetFrameTime (duration);
+
+  if (m_statistics)
+    {
+      if (m_renderThread != 0)
+        {
+          // the expose only blits, frames are drawn by the render thread
+          m_renderThread->TakeFrames (m_frames);
+        }
+      else
+        {
+          m_frames.push_back (std::make_pair (start, duration));
+        }
+      while (m_frames.size () > STATISTICS_FRAMES)
+        {
+          m_frames.pop_front ();
+        }
+      if (!m_frames.empty ())
+        {
+          DrawStatistics (context);
+        }
+    }
+
+  return true;
+}
+
+void
+Scene::Render (const Cairo::RefPtr<Cairo::Context> &context)
+{
   context->save ();
   context->set_source_rgba (1.0, 1.0, 1.0, 1);
   context->paint ();
@@ -262,16 +411,95 @@ Scene::HandleExpose (GdkEventExpose* event)
   context->restore ();
 
   Gtk::Allocation allocation = get_allocation ();
+  DrawBorder (context, allocation.get_width (), allocation.get_height ());
+
+  context->restore ();
+}
+
+void
+Scene::RenderThreaded (const Cairo::RefPtr<Cairo::Context> &context)
+{
+  Cairo::Matrix matrix;
+  context->save ();
+  ApplyTransformation (context);
+  context->get_matrix (matrix);
+  context->restore ();
+
+  // A frame is requested only when something has changed, otherwise the
+  // redraw caused by a completed frame would request the next one forever.
+  Gtk::Allocation allocation = get_allocation ();
+  bool entered = m_manager.Advance (matrix);
+  m_renderThread->Request (matrix, allocation.get_width (), allocation.get_height (), entered || m_renderDirty);
+  m_renderDirty = false;
+
+  context->save ();
+  context->set_source_rgba (1.0, 1.0, 1.0, 1);
+  context->paint ();
+
+  m_renderThread->Blit (context, matrix);
+
+  context->save ();
+  ApplyTransformation (context);
+  m_manager.Render (context);
+  context->restore ();
+
+  DrawBorder (context, allocation.get_width (), allocation.get_height ());
+
+  context->restore ();
+}
+
+void
+Scene::RenderTiled (const Cairo::RefPtr<Cairo::Context> &context, GdkEventExpose* event)
+{
+  // Motions are advanced once on the GTK thread, the workers only draw them
+  Cairo::Matrix matrix;
+  context->save ();
+  ApplyTransformation (context);
+  context->get_matrix (matrix);
+  context->restore ();
+  m_manager.Advance (matrix);
+
+  Gtk::Allocation allocation = get_allocation ();
+  int width = allocation.get_width ();
+  int height = allocation.get_height ();
+  if (!m_tileSurface || m_tileSurface->get_width () != width || m_tileSurface->get_height () != height)
+    {
+      m_tileSurface = Cairo::ImageSurface::create (Cairo::FORMAT_RGB24, width, height);
+    }
+
+  // only the damaged tiles are redrawn, the others keep the previous frame
+  m_tileRenderer.Render (m_tileSurface, event->region,
+    sigc::bind (sigc::mem_fun (*this, &Scene::RenderTile), matrix, width, height));
+
+  context->save ();
+  context->set_operator (Cairo::OPERATOR_SOURCE);
+  context->set_source (m_tileSurface, 0, 0);
+  context->paint ();
+  context->restore ();
+}
+
+void
+Scene::RenderTile (const Cairo::RefPtr<Cairo::Context> &context, Cairo::Matrix matrix, int width, int height) const
+{
+  context->set_source_rgba (1.0, 1.0, 1.0, 1);
+  context->paint ();
+
+  context->save ();
+  context->set_matrix (matrix);
+  m_manager.Render (context);
+  context->restore ();
 
+  DrawBorder (context, width, height);
+}
+
+void
+Scene::DrawBorder (const Cairo::RefPtr<Cairo::Context> &context, int width, int height) const
+{
   context->set_line_cap (Cairo::LINE_CAP_SQUARE);
   context->set_line_width (m_borderWidth);
   context->set_source_rgba (m_borderColor.r, m_borderColor.g, m_borderColor.b, m_borderColor.a);
-  context->rectangle (0, 0, allocation.get_width (), allocation.get_height ());
+  context->rectangle (0, 0, width, height);
   context->stroke ();
-
-  context->restore ();
-
-  return true;
 }
 
 bool
@@ -391,3 +619,84 @@ Scene::HandleRotation (GdkEventMotion* event)
 
   return true;
 }
+
+bool
+Scene::HandleQueryTooltip (int x, int y, bool keyboard, const Glib::RefPtr<Gtk::Tooltip> &tooltip)
+{
+  if (keyboard || m_motionType != MOTION_NONE)
+    {
+      return false;
+    }
+
+  double ux, uy;
+  Glib::ustring info;
+  GetUserCoords (x, y, ux, uy);
+  if (!m_manager.Pick (ux, uy, PICK_TOLERANCE / (m_scale * m_zoom), info))
+    {
+      return false;
+    }
+
+  tooltip->set_text (info);
+  return true;
+}
+
+void
+Scene::DrawStatistics (const Cairo::RefPtr<Cairo::Context> &context)
+{
+  std::vector<double> times;
+  for (std::deque<std::pair<double, double> >::const_iterator i = m_frames.begin (); i != m_frames.end (); ++i)
+    {
+      times.push_back ((*i).second * 1000);
+    }
+  std::sort (times.begin (), times.end ());
+
+  double span = m_frames.back ().first - m_frames.front ().first;
+  double fps = span > 0 ? (m_frames.size () - 1) / span : 0;
+  Glib::ustring text = Glib::ustring::compose ("%1 fps, frame p50 %2 ms, p99 %3 ms, %4 dropped, degradation %5\n",
+    Glib::ustring::format (std::fixed, std::setprecision (1), fps),
+    Glib::ustring::format (std::fixed, std::setprecision (2), times[times.size () / 2]),
+    Glib::ustring::format (std::fixed, std::setprecision (2), times[times.size () * 99 / 100]),
+    m_manager.GetDroppedFrames (), m_manager.GetDegradation ());
+
+  Gtk::Allocation allocation = get_allocation ();
+  m_manager.GetStatistics (GetTransformation (), allocation.get_width (), allocation.get_height (), text);
+
+  std::vector<Glib::ustring> lines;
+  for (Glib::ustring::size_type begin = 0, end; begin < text.size (); begin = end + 1)
+    {
+      end = text.find ('\n', begin);
+      end = end == Glib::ustring::npos ? text.size () : end;
+      lines.push_back (text.substr (begin, end - begin));
+    }
+
+  context->save ();
+  context->select_font_face ("monospace", Cairo::FONT_SLANT_NORMAL, Cairo::FONT_WEIGHT_NORMAL);
+  context->set_font_size (11);
+  Cairo::FontExtents font;
+  context->get_font_extents (font);
+
+  double width = 0;
+  for (std::vector<Glib::ustring>::const_iterator i = lines.begin (); i != lines.end (); ++i)
+    {
+      Cairo::TextExtents extents;
+      context->get_text_extents (*i, extents);
+      width = std::max (width, extents.x_advance);
+    }
+
+  // the overlay changes every frame, so it is redrawn with the motion damage
+  const double padding = 4, margin = 8;
+  Gdk::Rectangle rect ((int)margin, (int)margin, (int)std::ceil (width + 2 * padding),
+    (int)std::ceil (lines.size () * font.height + 2 * padding));
+  m_manager.SetOverlay (rect);
+
+  context->set_source_rgba (0, 0, 0, 0.6);
+  context->rectangle (rect.get_x (), rect.get_y (), rect.get_width (), rect.get_height ());
+  context->fill ();
+  context->set_source_rgba (1, 1, 1, 1);
+  for (uint32_t i = 0; i < lines.size (); ++i)
+    {
+      context->move_to (margin + padding, margin + padding + i * font.height + font.ascent);
+      context->show_text (lines[i]);
+    }
+  context->restore ();
+}
@@ -22,11 +22,15 @@
 #define SCENE_H
 
 #include <stdint.h>
+#include <deque>
+#include <utility>
 #include <gtkmm.h>
 
 #include "common.h"
 #include "motion.h"
 #include "motion-manager.h"
+#include "render-thread.h"
+#include "tile-renderer.h"
 
 class Scene: public Gtk::DrawingArea
 {
@@ -110,6 +114,18 @@ public:
    */
   void GetSceneCoords (uint32_t x, uint32_t y, double &sx, double &sy) const;
   void GetSceneCoords (double sceneX, double sceneY, uint32_t x, uint32_t y, double &sx, double &sy) const;
+  /**
+   * \param x
+   * \param y viewport coordinates
+   * \param &ux
+   * \param &uy
+   * Converts viewport coordinates to the user coordinates motions are drawn in
+   */
+  void GetUserCoords (double x, double y, double &ux, double &uy) const;
+  /**
+   * \returns user to viewport transformation
+   */
+  Cairo::Matrix GetTransformation (void) const;
   /**
    * \returns scene viewport rectange
    */
@@ -127,6 +143,30 @@ public:
    * \returns current motion rate
    */
   uint32_t GetRate (void) const;
+  /**
+   * \param threads number of threads rasterizing large frames, 1 disables tiling
+   */
+  void SetRenderThreads (uint32_t threads);
+  /**
+   * \returns number of rendering threads
+   */
+  uint32_t GetRenderThreads (void) const;
+  /**
+   * \param enable show frame rate, frame times and motion statistics over the scene
+   */
+  void SetStatistics (bool enable);
+  /**
+   * \returns true if statistics are shown
+   */
+  bool IsStatistics (void) const;
+  /**
+   * \param seconds per frame budget of motions, 0 disables degradation of slow motions
+   */
+  void SetFrameBudget (double seconds);
+  /**
+   * \returns per frame budget of motions
+   */
+  double GetFrameBudget (void) const;
   /**
    * \brief enable or disable "full" motion
    */
@@ -137,6 +177,8 @@ public:
   void Invalidate (void);
   /**
    * \param motion
+   *
+   * Threaded motions are drawn by a render thread below all other motions.
    */
   void AddMotion (const Glib::RefPtr<Motion> &motion);
   /**
@@ -166,11 +208,18 @@ private:
   };
 
   bool HandleExpose (GdkEventExpose* event);
+  void Render (const Cairo::RefPtr<Cairo::Context> &context);
+  void RenderTiled (const Cairo::RefPtr<Cairo::Context> &context, GdkEventExpose* event);
+  void RenderThreaded (const Cairo::RefPtr<Cairo::Context> &context);
+  void RenderTile (const Cairo::RefPtr<Cairo::Context> &context, Cairo::Matrix matrix, int width, int height) const;
+  void DrawBorder (const Cairo::RefPtr<Cairo::Context> &context, int width, int height) const;
+  void DrawStatistics (const Cairo::RefPtr<Cairo::Context> &context);
   bool HandleScroll (GdkEventScroll* event);
   bool HandleButtonPress (GdkEventButton* event);
   bool HandleButtonRelease (GdkEventButton* event);
   bool HandleMoving (GdkEventMotion* event);
   bool HandleRotation (GdkEventMotion* event);
+  bool HandleQueryTooltip (int x, int y, bool keyboard, const Glib::RefPtr<Gtk::Tooltip> &tooltip);
 
   double        m_zoom;
   double        m_zoomStep;
@@ -188,6 +237,13 @@ private:
   double        m_motionAngle;
   sigc::connection m_motionConnection;
   MotionManager m_manager;
+  TileRenderer  m_tileRenderer; // shared with the render thread
+  Cairo::RefPtr<Cairo::ImageSurface> m_tileSurface; // frame rasterized in tiles, GTK thread only
+  RenderThread  *m_renderThread; // draws threaded motions
+  bool          m_renderDirty; // threaded motions must be redrawn
+  bool          m_statistics;
+  Glib::Timer   m_clock;
+  std::deque<std::pair<double, double> > m_frames; // start and duration of recent exposes, or of render thread frames
 };
 
 #endif /* SCENE_H */
@@ -0,0 +1,109 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+
+#include "nam-busy-time.h"
+
+// busy intervals walked by a cursor before falling back to a binary search
+static const uint32_t BUSY_SCAN = 8;
+
+NamBusyTime::NamBusyTime ()
+{
+}
+
+void
+NamBusyTime::Build (const std::vector<Packet> &packets, uint32_t series)
+{
+  m_offsets.assign (series + 1, 0);
+  for (std::vector<Packet>::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      m_offsets[(*i).GetSeries () + 1]++;
+    }
+  for (uint32_t i = 1; i <= series; ++i)
+    {
+      m_offsets[i] += m_offsets[i - 1];
+    }
+
+  // packets are sorted by the first bit, so are the intervals of every series
+  m_start.resize (packets.size ());
+  m_end.resize (packets.size ());
+  m_before.resize (packets.size ());
+  std::vector<uint32_t> cursor (m_offsets.begin (), m_offsets.end () - 1);
+  for (std::vector<Packet>::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      uint32_t j = cursor[(*i).GetSeries ()]++;
+      m_start[j] = (*i).GetFirstBitTx ();
+      m_end[j] = std::max ((*i).GetFirstBitTx (), (*i).GetLastBitTx ());
+    }
+
+  for (uint32_t i = 0; i < series; ++i)
+    {
+      double busy = 0;
+      double last = 0;
+      for (uint32_t j = m_offsets[i]; j < m_offsets[i + 1]; ++j)
+        {
+          // overlapping transmissions count once, covered ones become empty
+          if (j > m_offsets[i])
+            {
+              m_start[j] = std::max (m_start[j], last);
+              m_end[j] = std::max (m_end[j], m_start[j]);
+            }
+          last = m_end[j];
+          m_before[j] = busy;
+          busy += m_end[j] - m_start[j];
+        }
+    }
+}
+
+uint32_t
+NamBusyTime::GetCursor (uint32_t series) const
+{
+  return m_offsets[series];
+}
+
+double
+NamBusyTime::GetBusyTime (uint32_t series, double time, uint32_t &cursor) const
+{
+  uint32_t begin = m_offsets[series];
+  uint32_t end = m_offsets[series + 1];
+  if (begin == end)
+    {
+      return 0;
+    }
+
+  // playback moves the cursor by a few intervals per frame, seeks need a search
+  for (uint32_t steps = 0; steps < BUSY_SCAN && cursor < end && m_start[cursor] <= time; ++steps)
+    {
+      ++cursor;
+    }
+  if ((cursor < end && m_start[cursor] <= time) || (cursor > begin && m_start[cursor - 1] > time))
+    {
+      cursor = std::upper_bound (m_start.begin () + begin, m_start.begin () + end, time) - m_start.begin ();
+    }
+
+  if (cursor == begin)
+    {
+      return 0;
+    }
+
+  uint32_t j = cursor - 1;
+  return m_before[j] + std::min (time, m_end[j]) - m_start[j];
+}
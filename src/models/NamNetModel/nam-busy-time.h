@@ -0,0 +1,66 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef NAM_BUSY_TIME_H
+#define NAM_BUSY_TIME_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "common.h"
+
+/**
+ * \brief Busy intervals of link directions with their prefix sums
+ *
+ * Intervals are stored in CSR layout, series i owns intervals
+ * [offsets[i], offsets[i + 1]). Overlapping transmissions are clipped
+ * so that every instant counts once, an interval covered by an earlier
+ * one becomes empty. Starts stay sorted within a series.
+ */
+class NamBusyTime
+{
+public:
+  NamBusyTime ();
+  /**
+   * \param packets hops sorted by the first bit transmission time
+   * \param series number of link directions
+   */
+  void Build (const std::vector<Packet> &packets, uint32_t series);
+  /**
+   * \param series link direction (2 * link + direction)
+   * \returns cursor positioned before the first busy interval of series
+   */
+  uint32_t GetCursor (uint32_t series) const;
+  /**
+   * \param series link direction (2 * link + direction)
+   * \param time trace time
+   * \param cursor first interval starting after the previous query time, updated
+   * \returns total transmission time on the link direction up to time
+   */
+  double GetBusyTime (uint32_t series, double time, uint32_t &cursor) const;
+
+private:
+  std::vector<uint32_t> m_offsets;
+  std::vector<double>   m_start;
+  std::vector<double>   m_end;
+  std::vector<double>   m_before; // busy time of the series before the interval
+};
+
+#endif /* NAM_BUSY_TIME_H */
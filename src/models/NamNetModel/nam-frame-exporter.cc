@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include "algorithm.h"
+#include "error.h"
+#include "nam-frame-exporter.h"
+
+NamFrameExporter::NamFrameExporter (const std::string &filename)
+  : m_filename (filename),
+    m_from (0),
+    m_to (-1),
+    m_rate (25),
+    m_width (1280),
+    m_height (720),
+    m_threads (1),
+    m_zoom (1)
+{
+}
+
+NamFrameExporter::~NamFrameExporter ()
+{
+}
+
+void
+NamFrameExporter::SetTimeRange (double from, double to)
+{
+  m_from = from;
+  m_to = to;
+}
+
+void
+NamFrameExporter::SetRate (uint32_t fps)
+{
+  m_rate = fps;
+}
+
+void
+NamFrameExporter::SetSize (uint32_t width, uint32_t height)
+{
+  m_width = width;
+  m_height = height;
+}
+
+void
+NamFrameExporter::SetThreads (uint32_t threads)
+{
+  m_threads = threads;
+}
+
+void
+NamFrameExporter::ExportSnapshot (const std::string &filename)
+{
+  if (m_width == 0 || m_height == 0)
+    {
+      throw Error ("Invalid frame size");
+    }
+
+  Glib::RefPtr<NamNetMotion> motion = Load ();
+  algorithm::Scale (Rectangle (0, 0, m_width, m_height), motion->GetNodes (), motion->GetNodeWidth (), m_zoom, m_center);
+  motion->Seek (m_from);
+  WriteSnapshot (motion, GetMatrix (), m_width, m_height, filename);
+}
+
+void
+NamFrameExporter::WriteSnapshot (const Glib::RefPtr<NamNetMotion> &motion, const Cairo::Matrix &matrix,
+  uint32_t width, uint32_t height, const std::string &filename)
+{
+  Cairo::RefPtr<Cairo::Surface> surface;
+  std::string extension = filename.substr (std::min (filename.size (), filename.rfind ('.') + 1));
+  std::transform (extension.begin (), extension.end (), extension.begin (), ::tolower);
+
+#ifdef CAIRO_HAS_SVG_SURFACE
+  if (extension == "svg")
+    {
+      surface = Cairo::SvgSurface::create (filename, width, height);
+    }
+#endif
+#ifdef CAIRO_HAS_PDF_SURFACE
+  if (extension == "pdf")
+    {
+      surface = Cairo::PdfSurface::create (filename, width, height);
+    }
+#endif
+  if (!surface)
+    {
+      throw Error ("Unsupported snapshot format " + filename);
+    }
+
+  Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (surface);
+  context->set_source_rgba (1.0, 1.0, 1.0, 1);
+  context->paint ();
+
+  // The motion culls everything outside the clip and strokes each style
+  // once, so the file holds one path per style with visible geometry only.
+  context->rectangle (0, 0, width, height);
+  context->clip ();
+  context->transform (matrix);
+  motion->DrawFrame (context);
+
+  context->show_page ();
+  surface->finish ();
+}
+
+uint32_t
+NamFrameExporter::Export (const std::string &directory)
+{
+  if (m_rate == 0 || m_width == 0 || m_height == 0)
+    {
+      throw Error ("Invalid frame rate or size");
+    }
+
+  if (g_mkdir_with_parents (directory.c_str (), 0755) != 0)
+    {
+      throw Error ("Could not create directory " + directory);
+    }
+
+  m_directory = directory;
+  m_error.clear ();
+  Glib::RefPtr<NamNetMotion> motion = Load ();
+
+  double to = m_to < 0 ? motion->GetLastTime () : m_to;
+  if (to < m_from)
+    {
+      return 0;
+    }
+
+  uint32_t frames = (uint32_t)std::floor ((to - m_from) * m_rate + 1E-9) + 1;
+
+  // fit the whole topology into the frame, as the scene does after loading
+  algorithm::Scale (Rectangle (0, 0, m_width, m_height), motion->GetNodes (), motion->GetNodeWidth (), m_zoom, m_center);
+
+  // the trace is parsed once, every thread only keeps its own view of it
+  uint32_t threads = std::max (1u, std::min (m_threads, frames));
+  std::vector<Glib::Thread*> workers;
+  for (uint32_t i = 1; i < threads; i++)
+    {
+      Glib::RefPtr<NamNetMotion> view = NamNetMotion::Create ();
+      view->SetTrace (motion->GetTrace ());
+      workers.push_back (Glib::Thread::create (sigc::bind (sigc::mem_fun (*this, &NamFrameExporter::ExportFrames),
+        view, frames * i / threads, frames * (i + 1) / threads), true));
+    }
+
+  ExportFrames (motion, 0, frames / threads);
+
+  for (std::vector<Glib::Thread*>::iterator i = workers.begin (); i != workers.end (); ++i)
+    {
+      (*i)->join ();
+    }
+
+  if (!m_error.empty ())
+    {
+      throw Error (m_error);
+    }
+
+  return frames;
+}
+
+Glib::RefPtr<NamNetMotion>
+NamFrameExporter::Load (void) const
+{
+  Glib::RefPtr<Gio::File> file = Gio::File::create_for_path (m_filename);
+  Glib::RefPtr<Gio::DataInputStream> stream = Gio::DataInputStream::create (file->read ());
+  Glib::RefPtr<NamNetMotion> motion = NamNetMotion::Create ();
+  motion->LoadMotion (stream);
+  return motion;
+}
+
+void
+NamFrameExporter::ExportFrames (Glib::RefPtr<NamNetMotion> motion, uint32_t first, uint32_t last)
+{
+  // An exception must not leave a worker thread, the first one is
+  // reported by Export once all threads are done.
+  std::string error;
+  try
+  {
+    // every frame is placed from its number, so that no time accumulates
+    for (uint32_t frame = first; frame < last; frame++)
+      {
+        motion->Seek (m_from + (double)frame / m_rate);
+        DrawFrame (motion, frame);
+      }
+  }
+  catch (Glib::Exception &e)
+  {
+    error = e.what ();
+  }
+  catch (std::exception &e)
+  {
+    error = e.what ();
+  }
+
+  if (!error.empty ())
+    {
+      Glib::Mutex::Lock lock (m_errorMutex);
+      if (m_error.empty ())
+        {
+          m_error = error;
+        }
+    }
+}
+
+Cairo::Matrix
+NamFrameExporter::GetMatrix (void) const
+{
+  Cairo::Matrix matrix;
+  cairo_matrix_init_translate (&matrix, m_width / 2.0, m_height / 2.0);
+  cairo_matrix_scale (&matrix, m_zoom, m_zoom);
+  cairo_matrix_translate (&matrix, -m_center.x, -m_center.y);
+  return matrix;
+}
+
+void
+NamFrameExporter::DrawFrame (const Glib::RefPtr<NamNetMotion> &motion, uint32_t frame)
+{
+  Cairo::RefPtr<Cairo::ImageSurface> surface = Cairo::ImageSurface::create (Cairo::FORMAT_RGB24, m_width, m_height);
+  Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (surface);
+
+  context->set_source_rgba (1.0, 1.0, 1.0, 1);
+  context->paint ();
+
+  context->transform (GetMatrix ());
+  motion->DrawFrame (context);
+
+  char name[32];
+  snprintf (name, sizeof (name), "frame-%06u.png", frame);
+  surface->write_to_png (Glib::build_filename (m_directory, name));
+}
@@ -0,0 +1,107 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef NAM_FRAME_EXPORTER_H
+#define NAM_FRAME_EXPORTER_H
+
+#include <stdint.h>
+#include <string>
+
+#include <gtkmm.h>
+#include "common.h"
+#include "nam-net-motion.h"
+
+/**
+ * \brief Renders a NAM trace to a PNG sequence without any window
+ *
+ * Frames are split into contiguous chunks, one per thread. Every thread
+ * seeks its own motion over the shared trace to the time of each frame
+ * of its chunk; forward seeks reuse the packets in flight.
+ */
+class NamFrameExporter
+{
+public:
+  /**
+   * \param filename trace file
+   */
+  NamFrameExporter (const std::string &filename);
+  virtual ~NamFrameExporter ();
+  /**
+   * \param from first frame time
+   * \param to last frame time, negative value means the end of the trace
+   */
+  void SetTimeRange (double from, double to);
+  /**
+   * \param fps frames per second of trace time
+   */
+  void SetRate (uint32_t fps);
+  /**
+   * \param width frame width
+   * \param height frame height
+   */
+  void SetSize (uint32_t width, uint32_t height);
+  /**
+   * \param threads number of rendering threads
+   */
+  void SetThreads (uint32_t threads);
+  /**
+   * \param directory output directory, created if missing
+   * \returns number of written frames, throws Error if any frame could not be written
+   */
+  uint32_t Export (const std::string &directory);
+  /**
+   * \brief write the frame at the start of the time range as a vector image
+   * \param filename SVG or PDF file, chosen by the extension
+   */
+  void ExportSnapshot (const std::string &filename);
+  /**
+   * \brief write the current frame of motion as a vector image
+   * \param motion
+   * \param matrix user to image transformation
+   * \param width image width
+   * \param height image height
+   * \param filename SVG or PDF file, chosen by the extension
+   *
+   * Only geometry within the image is written.
+   */
+  static void WriteSnapshot (const Glib::RefPtr<NamNetMotion> &motion, const Cairo::Matrix &matrix,
+    uint32_t width, uint32_t height, const std::string &filename);
+
+private:
+  Glib::RefPtr<NamNetMotion> Load (void) const;
+  void ExportFrames (Glib::RefPtr<NamNetMotion> motion, uint32_t first, uint32_t last);
+  void DrawFrame (const Glib::RefPtr<NamNetMotion> &motion, uint32_t frame);
+  Cairo::Matrix GetMatrix (void) const;
+
+  std::string   m_filename;
+  std::string   m_directory;
+  double        m_from;
+  double        m_to;
+  uint32_t      m_rate;
+  uint32_t      m_width;
+  uint32_t      m_height;
+  uint32_t      m_threads;
+  double        m_zoom;
+  Point         m_center;
+  Glib::Mutex   m_errorMutex;
+  std::string   m_error; // first error of the rendering threads
+};
+
+#endif /* NAM_FRAME_EXPORTER_H */
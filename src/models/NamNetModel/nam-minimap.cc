@@ -0,0 +1,243 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "nam-minimap.h"
+
+// minimap size relative to the smaller scene dimension
+static const double MINIMAP_FRACTION = 0.25;
+// distance of the minimap from the scene corner and of the topology from the minimap border
+static const double MINIMAP_MARGIN = 8.0;
+// number of occupancy intensity levels
+static const uint32_t MINIMAP_LEVELS = 4;
+
+NamMinimap::NamMinimap (const Glib::RefPtr<NamNetMotion> &motion)
+  : m_motion (motion),
+    m_x (0),
+    m_y (0),
+    m_width (0),
+    m_height (0),
+    m_sceneWidth (0),
+    m_sceneHeight (0)
+{
+  cairo_matrix_init_identity (&m_matrix);
+}
+
+NamMinimap::~NamMinimap ()
+{
+}
+
+Glib::RefPtr<NamMinimap>
+NamMinimap::Create (const Glib::RefPtr<NamNetMotion> &motion)
+{
+  return Glib::RefPtr<NamMinimap> (new NamMinimap (motion));
+}
+
+void
+NamMinimap::Update (uint32_t width, uint32_t height)
+{
+  m_sceneWidth = width;
+  m_sceneHeight = height;
+  m_thumbnail.clear ();
+
+  std::vector<Node> nodes = m_motion->GetNodes ();
+  if (nodes.empty ())
+    {
+      return;
+    }
+
+  double left = nodes[0].x, top = nodes[0].y, right = nodes[0].x, bottom = nodes[0].y;
+  for (std::vector<Node>::const_iterator i = nodes.begin (); i != nodes.end (); ++i)
+    {
+      left = std::min (left, (*i).x);
+      top = std::min (top, (*i).y);
+      right = std::max (right, (*i).x);
+      bottom = std::max (bottom, (*i).y);
+    }
+
+  double size = std::min (width, height) * MINIMAP_FRACTION;
+  double extent = std::max (std::max (right - left, bottom - top), 1e-9);
+  double scale = std::max (size - 2 * MINIMAP_MARGIN, 1.0) / extent;
+  m_width = (uint32_t)std::ceil ((right - left) * scale + 2 * MINIMAP_MARGIN);
+  m_height = (uint32_t)std::ceil ((bottom - top) * scale + 2 * MINIMAP_MARGIN);
+  m_x = width - m_width - MINIMAP_MARGIN;
+  m_y = height - m_height - MINIMAP_MARGIN;
+
+  cairo_matrix_init_translate (&m_matrix, MINIMAP_MARGIN, MINIMAP_MARGIN);
+  cairo_matrix_scale (&m_matrix, scale, scale);
+  cairo_matrix_translate (&m_matrix, -left, -top);
+
+  m_thumbnail = Cairo::ImageSurface::create (Cairo::FORMAT_ARGB32, m_width, m_height);
+  Cairo::RefPtr<Cairo::Context> context = Cairo::Context::create (m_thumbnail);
+  context->set_source_rgba (1.0, 1.0, 1.0, 0.85);
+  context->paint ();
+  context->set_line_width (1.0);
+  context->set_source_rgba (0.75, 0.75, 0.75, 1);
+  context->rectangle (0.5, 0.5, m_width - 1, m_height - 1);
+  context->stroke ();
+
+  // geometry is transformed by hand, so that lines stay one pixel wide
+  const std::vector<Edge> &edges = m_motion->GetEdges ();
+  RgbaColor color = m_motion->GetEdgeColor ();
+  context->set_source_rgba (color.r, color.g, color.b, color.a);
+  for (std::vector<Edge>::const_iterator i = edges.begin (); i != edges.end (); ++i)
+    {
+      double x1 = (*i).n1->x, y1 = (*i).n1->y, x2 = (*i).n2->x, y2 = (*i).n2->y;
+      cairo_matrix_transform_point (&m_matrix, &x1, &y1);
+      cairo_matrix_transform_point (&m_matrix, &x2, &y2);
+      context->move_to (x1, y1);
+      context->line_to (x2, y2);
+    }
+  context->stroke ();
+
+  color = m_motion->GetNodeColor ();
+  context->set_source_rgba (color.r, color.g, color.b, color.a);
+  for (std::vector<Node>::const_iterator i = nodes.begin (); i != nodes.end (); ++i)
+    {
+      double x = (*i).x, y = (*i).y;
+      cairo_matrix_transform_point (&m_matrix, &x, &y);
+      context->rectangle (x - 1, y - 1, 2, 2);
+    }
+  context->fill ();
+}
+
+bool
+NamMinimap::GetUserPoint (double x, double y, Point &point) const
+{
+  if (!m_thumbnail || x < m_x || y < m_y || x >= m_x + m_width || y >= m_y + m_height)
+    {
+      return false;
+    }
+
+  Cairo::Matrix matrix = m_matrix;
+  point.x = x - m_x;
+  point.y = y - m_y;
+  cairo_matrix_invert (&matrix);
+  cairo_matrix_transform_point (&matrix, &point.x, &point.y);
+  return true;
+}
+
+void
+NamMinimap::DrawFrame (const Cairo::RefPtr<Cairo::Context> &context)
+{
+  if (!m_thumbnail)
+    {
+      return;
+    }
+
+  // the scene transformation tells which part of the topology is visible
+  Cairo::Matrix scene;
+  context->get_matrix (scene);
+  bool visible = cairo_matrix_invert (&scene) == CAIRO_STATUS_SUCCESS;
+
+  context->save ();
+  context->set_identity_matrix ();
+  context->rectangle (m_x, m_y, m_width, m_height);
+  context->clip ();
+  // raw surface, m_thumbnail is shared by the tile workers
+  cairo_set_source_surface (context->cobj (), m_thumbnail->cobj (), m_x, m_y);
+  context->paint ();
+
+  context->translate (m_x, m_y);
+  DrawOccupancy (context);
+
+  if (visible)
+    {
+      for (uint32_t i = 0; i < 4; ++i)
+        {
+          // corners of the scene, clockwise
+          double x = (i == 1 || i == 2) ? m_sceneWidth : 0;
+          double y = (i >= 2) ? m_sceneHeight : 0;
+          cairo_matrix_transform_point (&scene, &x, &y);
+          cairo_matrix_transform_point (&m_matrix, &x, &y);
+          if (i == 0)
+            {
+              context->move_to (x, y);
+            }
+          else
+            {
+              context->line_to (x, y);
+            }
+        }
+      context->close_path ();
+      context->set_line_width (1.0);
+      context->set_source_rgba (0.8, 0.1, 0.1, 0.9);
+      context->stroke ();
+    }
+
+  context->restore ();
+}
+
+void
+NamMinimap::DrawOccupancy (const Cairo::RefPtr<Cairo::Context> &context) const
+{
+  std::vector<uint32_t> counts;
+  m_motion->GetOccupancy (counts);
+  uint32_t maximum = 0;
+  for (uint32_t i = 0; i < counts.size (); ++i)
+    {
+      maximum = std::max (maximum, counts[i]);
+    }
+  if (maximum == 0)
+    {
+      return;
+    }
+
+  const std::vector<Edge> &edges = m_motion->GetEdges ();
+  RgbaColor color = m_motion->GetPacketColor ();
+  context->set_line_width (2.0);
+  for (uint32_t level = 0; level < MINIMAP_LEVELS; ++level)
+    {
+      bool drawn = false;
+      for (uint32_t i = 0; i < counts.size (); ++i)
+        {
+          if (counts[i] == 0 || (counts[i] - 1) * MINIMAP_LEVELS / maximum != level)
+            {
+              continue;
+            }
+          double x1 = edges[i].n1->x, y1 = edges[i].n1->y, x2 = edges[i].n2->x, y2 = edges[i].n2->y;
+          cairo_matrix_transform_point (&m_matrix, &x1, &y1);
+          cairo_matrix_transform_point (&m_matrix, &x2, &y2);
+          context->move_to (x1, y1);
+          context->line_to (x2, y2);
+          drawn = true;
+        }
+
+      if (drawn)
+        {
+          context->set_source_rgba (color.r, color.g, color.b, (level + 1.0) / MINIMAP_LEVELS);
+          context->stroke ();
+        }
+    }
+}
+
+bool
+NamMinimap::GetDamage (const Cairo::Matrix &matrix, uint32_t rate, Gdk::Region &region)
+{
+  // occupancy and viewport change with the trace and the scene, only the minimap area is affected
+  if (m_thumbnail)
+    {
+      region.union_with_rect (Gdk::Rectangle ((int)m_x, (int)m_y, m_width, m_height));
+    }
+  return true;
+}
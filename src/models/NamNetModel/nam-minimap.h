@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef NAM_MINIMAP_H
+#define NAM_MINIMAP_H
+
+#include <stdint.h>
+
+#include <gtkmm.h>
+#include "common.h"
+#include "motion.h"
+#include "nam-net-motion.h"
+
+/**
+ * \brief Overview of the whole topology in a corner of the scene
+ *
+ * Links and nodes are rendered once into a cached thumbnail, on load and
+ * on resize. Every frame only the link occupancy and the viewport outline
+ * are drawn over it.
+ */
+class NamMinimap : public StaticMotion
+{
+public:
+  static Glib::RefPtr<NamMinimap> Create (const Glib::RefPtr<NamNetMotion> &motion);
+
+  virtual ~NamMinimap ();
+  /**
+   * \brief re-render the thumbnail
+   * \param width scene width
+   * \param height scene height
+   */
+  void Update (uint32_t width, uint32_t height);
+  /**
+   * \param x
+   * \param y scene viewport coordinates
+   * \param point user coordinates of the topology point shown there
+   * \returns true if the point is inside the minimap
+   */
+  bool GetUserPoint (double x, double y, Point &point) const;
+  // functions defined in base class Motion
+  virtual void DrawFrame (const Cairo::RefPtr<Cairo::Context> &context);
+  virtual bool GetDamage (const Cairo::Matrix &matrix, uint32_t rate, Gdk::Region &region);
+
+protected:
+  NamMinimap (const Glib::RefPtr<NamNetMotion> &motion);
+
+private:
+  void DrawOccupancy (const Cairo::RefPtr<Cairo::Context> &context) const;
+
+  Glib::RefPtr<NamNetMotion> m_motion;
+  Cairo::RefPtr<Cairo::ImageSurface> m_thumbnail;
+  Cairo::Matrix m_matrix; // user to minimap transformation
+  double        m_x;
+  double        m_y;
+  uint32_t      m_width;
+  uint32_t      m_height;
+  uint32_t      m_sceneWidth;
+  uint32_t      m_sceneHeight;
+};
+
+#endif /* NAM_MINIMAP_H */
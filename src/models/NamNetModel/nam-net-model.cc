@@ -18,6 +18,7 @@
  * Author: Andrey Churin <aachurin@gmail.com>
  */
 
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
@@ -26,9 +27,13 @@
 #include "algorithm.h"
 #include "nam-images.h"
 #include "nam-net-motion.h"
+#include "nam-frame-exporter.h"
 #include "nam-net-model.h"
 #include "nam-net-model.ui"
 
+// frames a time locked second view may drift from the first one before it is moved,
+// degraded views enter several frames at once
+static const double SECOND_VIEW_DRIFT = 8;
 
 ENSURE_REGISTER_MODEL (NamNetModel);
 
@@ -54,11 +59,30 @@ NamNetModel::Factory (void)
 }
 
 NamNetModel::NamNetModel ()
-  : NetModel (ui::NamNetModel)
+  : NetModel (ui::NamNetModel),
+    m_lockButton ("Lock time"),
+    m_timeOffset (0)
 {
   m_motion = NamNetMotion::Create ();
+  // keep input handling responsive while heavy frames are drawn
+  m_motion->SetThreaded (Glib::thread_supported ());
+  // prepare the next frame while the current one is drawn
+  m_motion->SetPipelined (Glib::thread_supported ());
+  m_motion->SetName ("trace");
+  // the trace gives way to zoom and move feedback when frames are slow
+  m_motion->SetPriority (Motion::PRIORITY_LOW);
+  // the second view only keeps its own cursor over the trace of the first
+  m_secondMotion = NamNetMotion::Create ();
+  m_secondMotion->SetThreaded (Glib::thread_supported ());
+  m_secondMotion->SetPipelined (Glib::thread_supported ());
+  m_secondMotion->SetName ("second trace");
+  m_secondMotion->SetPriority (Motion::PRIORITY_LOW);
+  m_minimap = NamMinimap::Create (m_motion);
+  m_minimap->SetName ("minimap");
   m_moveMotion = ImageMotion::Create (Gdk::Pixbuf::create_from_inline (48*48*4 + 24, images::move_image));
+  m_moveMotion->SetName ("move");
   m_rotateMotion = ImageMotion::Create (Gdk::Pixbuf::create_from_inline (48*48*4 + 24, images::rotate_image));
+  m_rotateMotion->SetName ("rotate");
 }
 
 NamNetModel::~NamNetModel ()
@@ -74,6 +98,14 @@ NamNetModel::Initialize (void)
   group->add (Gtk::Action::create ("Stop", Gtk::Stock::MEDIA_STOP), sigc::mem_fun (*this, &NamNetModel::HandleStop));
   group->add (Gtk::Action::create ("Rewind", Gtk::Stock::MEDIA_REWIND), sigc::mem_fun (*this, &NamNetModel::HandleRewind));
   group->add (Gtk::Action::create ("Forward", Gtk::Stock::MEDIA_FORWARD), sigc::mem_fun (*this, &NamNetModel::HandleForward));
+  m_heatmapAction = Gtk::ToggleAction::create ("Heatmap", Gtk::Stock::SELECT_COLOR, "Heatmap", "Color links by utilisation");
+  group->add (m_heatmapAction, sigc::mem_fun (*this, &NamNetModel::HandleHeatmap));
+  m_statisticsAction = Gtk::ToggleAction::create ("Statistics", Gtk::Stock::INFO, "Statistics", "Show frame statistics");
+  group->add (m_statisticsAction, sigc::mem_fun (*this, &NamNetModel::HandleStatistics));
+  m_splitAction = Gtk::ToggleAction::create ("Split", Gtk::Stock::COPY, "Split", "Show a second view of the trace");
+  group->add (m_splitAction, sigc::mem_fun (*this, &NamNetModel::HandleSplit));
+  group->add (Gtk::Action::create ("ExportSnapshot", Gtk::Stock::SAVE_AS, "_Export Snapshot..."),
+    sigc::mem_fun (*this, &NamNetModel::HandleExportSnapshot));
 
   m_scene.signal_zoom_change ().connect (sigc::mem_fun (*this, &NamNetModel::HandleZoomChange));
   m_scale.signal_change_value ().connect (sigc::mem_fun (*this, &NamNetModel::HandleScaleChange));
@@ -81,6 +113,12 @@ NamNetModel::Initialize (void)
   m_scale.signal_button_release_event ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSliderMovingEnd), false);
   m_zoomCombo.signal_changed ().connect (sigc::mem_fun (*this, &NamNetModel::HandleZoomChanged));
   m_speedScale.signal_value_changed ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSpeedChanged));
+  m_colorCombo.signal_changed ().connect (sigc::mem_fun (*this, &NamNetModel::HandleColorModeChanged));
+  m_secondScale.signal_change_value ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSecondScaleChange));
+  m_secondPlayButton.signal_toggled ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSecondPlay));
+  m_secondSpeedScale.signal_value_changed ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSecondSpeedChanged));
+  m_lockButton.set_active (true);
+  m_lockButton.signal_toggled ().connect (sigc::mem_fun (*this, &NamNetModel::HandleLock));
 
   m_speedLabel.set_width_chars (6);
 
@@ -103,10 +141,21 @@ NamNetModel::Initialize (void)
   m_zoomEntry.set_width_chars (5);
   m_zoomCombo.set_active (3);
 
+  // the order follows NamNetMotion::ColorMode
+  m_colorCombo.append_text ("Single");
+  m_colorCombo.append_text ("Flow");
+  m_colorCombo.append_text ("Link");
+  m_colorCombo.append_text ("Tag");
+  m_colorCombo.set_active (NamNetMotion::COLOR_SINGLE);
+
   topBox->pack_start (*Gtk::manage (new Gtk::Label ("Zoom:")), Gtk::PACK_SHRINK, 2);
   topBox->pack_start (m_zoomCombo, Gtk::PACK_SHRINK, 2);
   topBox->pack_start (*Gtk::manage (new Gtk::VSeparator ()), Gtk::PACK_SHRINK, 4);
 
+  topBox->pack_start (*Gtk::manage (new Gtk::Label ("Colors:")), Gtk::PACK_SHRINK, 2);
+  topBox->pack_start (m_colorCombo, Gtk::PACK_SHRINK, 2);
+  topBox->pack_start (*Gtk::manage (new Gtk::VSeparator ()), Gtk::PACK_SHRINK, 4);
+
   topBox->pack_start (*Gtk::manage (new Gtk::Label ("Interval:")), Gtk::PACK_SHRINK, 2);
   topBox->pack_start (m_speedLabel, Gtk::PACK_SHRINK, 2);
   topBox->pack_start (m_speedScale, Gtk::PACK_EXPAND_WIDGET, 6);
@@ -125,23 +174,56 @@ NamNetModel::Initialize (void)
   bottomBox->pack_start (*toolbar, Gtk::PACK_SHRINK);
   bottomBox->pack_start (m_scale, Gtk::PACK_EXPAND_WIDGET, 6);
 
+  // second view
+  Gtk::HBox* secondBottomBox = Gtk::manage (new Gtk::HBox ());
+  m_secondScale.set_draw_value (false);
+  m_secondPlayButton.set_use_stock (true);
+  m_secondPlayButton.set_label (Gtk::StockID (Gtk::Stock::MEDIA_PLAY).get_string ());
+  m_secondSpeedScale.set_draw_value (false);
+  m_secondSpeedScale.set_range (0, 20);
+  m_secondSpeedScale.set_increments (1, 2);
+  m_secondSpeedScale.set_value (10);
+  m_secondSpeedScale.set_size_request (100, -1);
+  m_secondSpeedLabel.set_width_chars (6);
+  secondBottomBox->pack_start (m_lockButton, Gtk::PACK_SHRINK, 6);
+  secondBottomBox->pack_start (m_secondPlayButton, Gtk::PACK_SHRINK, 2);
+  secondBottomBox->pack_start (m_secondSpeedLabel, Gtk::PACK_SHRINK, 2);
+  secondBottomBox->pack_start (m_secondSpeedScale, Gtk::PACK_SHRINK, 2);
+  secondBottomBox->pack_start (m_secondScale, Gtk::PACK_EXPAND_WIDGET, 6);
+  m_secondBox.pack_start (*GtkUtil::Alignment (m_secondScene, 0, 6));
+  m_secondBox.pack_start (*secondBottomBox, Gtk::PACK_SHRINK);
+  m_paned.pack1 (*GtkUtil::Alignment (m_scene, 0, 6), true, false);
+  m_paned.pack2 (m_secondBox, true, false);
+
   // base layout
   pack_start (*menubar, Gtk::PACK_SHRINK);
   pack_start (*GtkUtil::Alignment (*topBox, 6), Gtk::PACK_SHRINK);
-  pack_start (*GtkUtil::Alignment (m_scene, 0, 6));
+  pack_start (m_paned);
   pack_start (*bottomBox, Gtk::PACK_SHRINK);
 
   show_all_children ();
+  m_secondBox.hide ();
 
+  m_secondScene.SetFrameBudget (1.0 / m_secondScene.GetRate ());
+  m_secondScene.AddMotion (m_secondMotion);
+  m_scene.SetFrameBudget (1.0 / m_scene.GetRate ());
   m_scene.AddMotion (m_motion);
+  m_scene.AddMotion (m_minimap);
+  m_scene.signal_size_allocate ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSceneResize));
+  // a click on the minimap must not start moving the scene
+  m_scene.signal_button_press_event ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSceneButtonPress), false);
 
   m_motion->signal_enter_frame ().connect (sigc::mem_fun (*this, &NamNetModel::HandleMotion));
   m_motionStateConnection = m_motion->signal_state ().connect (sigc::mem_fun (*this, &NamNetModel::HandleMotionState));
+  m_secondMotion->signal_enter_frame ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSecondMotion));
+  m_secondMotion->signal_state ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSecondMotionState));
 
   m_scene.signal_move_motion ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSceneMove));
   m_scene.signal_rotate_motion ().connect (sigc::mem_fun (*this, &NamNetModel::HandleSceneRotate));
 
   HandleSpeedChanged ();
+  HandleSecondSpeedChanged ();
+  HandleLock ();
   HandleStop ();
 }
 
@@ -172,6 +254,33 @@ NamNetModel::Reset (void)
     {
       HandleSetZoom ();
     }
+
+  if (m_splitAction->get_active ())
+    {
+      FitSecondScene ();
+    }
+}
+
+void
+NamNetModel::HandleSceneResize (Gtk::Allocation& allocation)
+{
+  m_minimap->Update (allocation.get_width (), allocation.get_height ());
+}
+
+bool
+NamNetModel::HandleSceneButtonPress (GdkEventButton* event)
+{
+  Point point;
+  if (event->type != GDK_BUTTON_PRESS || event->button != 1 || !m_minimap->GetUserPoint (event->x, event->y, point))
+    {
+      return false;
+    }
+
+  // the scene center is applied after the rotation
+  double angle = m_scene.GetRotation ();
+  m_scene.SetCenter (-(point.x * std::cos (angle) - point.y * std::sin (angle)),
+                     -(point.x * std::sin (angle) + point.y * std::cos (angle)));
+  return true;
 }
 
 void
@@ -243,12 +352,249 @@ NamNetModel::CreateSpeedVector (void)
   m_speedVector.push_back (std::make_pair ("1s",    1.0));
 }
 
+void
+NamNetModel::HandleHeatmap (void)
+{
+  m_motion->SetHeatmap (m_heatmapAction->get_active ());
+  m_secondMotion->SetHeatmap (m_heatmapAction->get_active ());
+  m_scene.Invalidate ();
+  m_secondScene.Invalidate ();
+}
+
+void
+NamNetModel::HandleStatistics (void)
+{
+  m_scene.SetStatistics (m_statisticsAction->get_active ());
+  m_secondScene.SetStatistics (m_statisticsAction->get_active ());
+}
+
+void
+NamNetModel::HandleSplit (void)
+{
+  if (!m_splitAction->get_active ())
+    {
+      m_secondAllocConnection.disconnect ();
+      m_secondBox.hide ();
+      m_secondPlayButton.set_active (false);
+      m_secondMotion->Stop ();
+      return;
+    }
+
+  // the topology is fitted once the second scene has its size
+  m_secondAllocConnection.disconnect ();
+  m_secondAllocConnection = m_secondScene.signal_size_allocate ().connect (
+    sigc::mem_fun (*this, &NamNetModel::HandleSecondSceneAlloc));
+  m_secondBox.show ();
+  SyncSecondView ();
+}
+
+void
+NamNetModel::HandleSecondSceneAlloc (Gtk::Allocation& allocation)
+{
+  m_secondAllocConnection.disconnect ();
+  FitSecondScene ();
+}
+
+void
+NamNetModel::FitSecondScene (void)
+{
+  double zoom;
+  Point center;
+
+  m_secondScene.SetZoom (1.0);
+  Rectangle viewport = m_secondScene.GetSceneViewport ();
+  algorithm::Scale (viewport, m_secondMotion->GetNodes (), m_secondMotion->GetNodeWidth (), zoom, center);
+  m_secondScene.SetZoom (zoom);
+  m_secondScene.SetCenter (-center.x, -center.y);
+}
+
+void
+NamNetModel::HandleLock (void)
+{
+  bool locked = m_lockButton.get_active ();
+  m_secondScale.set_sensitive (!locked);
+  m_secondPlayButton.set_sensitive (!locked);
+  m_secondSpeedScale.set_sensitive (!locked);
+
+  if (locked)
+    {
+      // keep the current distance between the views
+      m_timeOffset = m_secondMotion->GetCurrentTime () - m_motion->GetCurrentTime ();
+      SyncSecondView ();
+    }
+  else
+    {
+      // the view keeps playing on its own controls
+      HandleSecondSpeedChanged ();
+      m_secondPlayButton.set_active (m_secondMotion->IsStarted ());
+    }
+}
+
+bool
+NamNetModel::HandleSecondScaleChange (Gtk::ScrollType scroll, double value)
+{
+  if (!m_lockButton.get_active ())
+    {
+      m_secondMotion->Seek (value);
+      m_secondScene.Invalidate ();
+    }
+  return false;
+}
+
+void
+NamNetModel::HandleSecondPlay (void)
+{
+  bool play = m_secondPlayButton.get_active ();
+  m_secondPlayButton.set_label (Gtk::StockID (play ? Gtk::Stock::MEDIA_PAUSE : Gtk::Stock::MEDIA_PLAY).get_string ());
+  if (m_lockButton.get_active ())
+    {
+      return;
+    }
+
+  if (play)
+    {
+      m_secondMotion->Start ();
+    }
+  else
+    {
+      m_secondMotion->Stop ();
+    }
+}
+
+void
+NamNetModel::HandleSecondSpeedChanged (void)
+{
+  int value = (int)m_secondSpeedScale.get_value ();
+  m_secondSpeedLabel.set_label (m_speedVector[value].first);
+  if (!m_lockButton.get_active ())
+    {
+      m_secondMotion->SetMotionSpeed (m_speedVector[value].second);
+    }
+}
+
+void
+NamNetModel::HandleSecondMotion (void)
+{
+  m_secondScale.set_value (m_secondMotion->GetCurrentTime ());
+}
+
+void
+NamNetModel::HandleSecondMotionState (const Motion *motion)
+{
+  // the view stops by itself at the end of the trace
+  if (!motion->IsStarted () && !m_lockButton.get_active ())
+    {
+      m_secondPlayButton.set_active (false);
+    }
+}
+
+bool
+NamNetModel::IsSecondLocked (void) const
+{
+  return m_lockButton.get_active () && m_splitAction->get_active ();
+}
+
+void
+NamNetModel::SyncSecondView (void)
+{
+  if (!IsSecondLocked ())
+    {
+      return;
+    }
+
+  // the second view enters its own frames with the speed of the first one,
+  // so it is only moved here and when the views drift apart
+  double time = std::min (m_motion->GetCurrentTime () + m_timeOffset, m_secondMotion->GetLastTime ());
+  m_secondMotion->SetMotionSpeed (m_motion->GetMotionSpeed ());
+  m_secondMotion->Seek (time);
+  if (m_motion->IsStarted () && time < m_secondMotion->GetLastTime ())
+    {
+      m_secondMotion->Start ();
+    }
+  else
+    {
+      m_secondMotion->Stop ();
+    }
+  m_secondScale.set_value (m_secondMotion->GetCurrentTime ());
+  m_secondScene.Invalidate ();
+}
+
+void
+NamNetModel::HandleExportSnapshot (void)
+{
+  Gtk::FileChooserDialog dialog ("Export snapshot", Gtk::FILE_CHOOSER_ACTION_SAVE);
+  Gtk::Window *window = dynamic_cast<Gtk::Window*> (get_toplevel ());
+  if (window)
+    {
+      dialog.set_transient_for (*window);
+    }
+
+  dialog.add_button (Gtk::Stock::CANCEL, Gtk::RESPONSE_CANCEL);
+  dialog.add_button (Gtk::Stock::SAVE, Gtk::RESPONSE_OK);
+  dialog.set_do_overwrite_confirmation (true);
+  dialog.set_current_name ("snapshot.svg");
+
+  Gtk::FileFilter filter;
+  filter.set_name ("SVG or PDF image");
+  filter.add_pattern ("*.svg");
+  filter.add_pattern ("*.pdf");
+  dialog.add_filter (filter);
+
+  if (dialog.run () != Gtk::RESPONSE_OK)
+    {
+      return;
+    }
+
+  // the snapshot shows what the scene shows
+  Gtk::Allocation allocation = m_scene.get_allocation ();
+  Glib::ustring error;
+  try
+  {
+    NamFrameExporter::WriteSnapshot (m_motion, m_scene.GetTransformation (),
+      allocation.get_width (), allocation.get_height (), dialog.get_filename ());
+  }
+  catch (Glib::Exception &e)
+  {
+    error = e.what ();
+  }
+  catch (std::exception &e)
+  {
+    error = e.what ();
+  }
+
+  if (!error.empty ())
+    {
+      dialog.hide ();
+      Gtk::MessageDialog message ("Snapshot could not be saved", false, Gtk::MESSAGE_ERROR);
+      message.set_secondary_text (error);
+      if (window)
+        {
+          message.set_transient_for (*window);
+        }
+      message.run ();
+    }
+}
+
+void
+NamNetModel::HandleColorModeChanged (void)
+{
+  int mode = m_colorCombo.get_active_row_number ();
+  if (mode >= 0)
+    {
+      m_motion->SetColorMode ((NamNetMotion::ColorMode)mode);
+      m_secondMotion->SetColorMode ((NamNetMotion::ColorMode)mode);
+      m_scene.Invalidate ();
+      m_secondScene.Invalidate ();
+    }
+}
+
 void
 NamNetModel::HandleSpeedChanged (void)
 {
   int value = (int)m_speedScale.get_value();
   m_motion->SetMotionSpeed (m_speedVector[value].second);
   m_speedLabel.set_label (m_speedVector[value].first);
+  SyncSecondView ();
 }
 
 void
@@ -293,6 +639,16 @@ NamNetModel::HandleMotion (void)
   double time = m_motion->GetCurrentTime ();
   SetMotionTime (time);
   m_scale.set_value (time);
+
+  if (IsSecondLocked ())
+    {
+      double target = std::min (time + m_timeOffset, m_secondMotion->GetLastTime ());
+      double drift = SECOND_VIEW_DRIFT * m_motion->GetMotionSpeed () / m_scene.GetRate ();
+      if (std::fabs (m_secondMotion->GetCurrentTime () - target) > drift)
+        {
+          SyncSecondView ();
+        }
+    }
 }
 
 void
@@ -314,6 +670,7 @@ NamNetModel::HandlePlay (void)
   m_motionStateConnection.block ();
   m_motion->Start ();
   m_motionStateConnection.unblock ();
+  SyncSecondView ();
 }
 
 void
@@ -325,6 +682,7 @@ NamNetModel::HandlePause (void)
   m_motionStateConnection.block ();
   m_motion->Stop ();
   m_motionStateConnection.unblock ();
+  SyncSecondView ();
 }
 
 void
@@ -336,6 +694,7 @@ NamNetModel::HandleStop (void)
   m_scale.set_value (0.0);
   m_motion->Seek (0.0);
   SetMotionTime (0.0);
+  SyncSecondView ();
 
   GetAction ("/Tool/Play")->set_visible (true);
   GetAction ("/Tool/Pause")->set_visible (false);
@@ -380,6 +739,7 @@ NamNetModel::HandleSliderMovingStart (GdkEventButton* event)
   m_motionStateConnection.block ();
   m_motion->Stop ();
   m_motionStateConnection.unblock ();
+  SyncSecondView ();
   return false;
 }
 
@@ -394,6 +754,7 @@ NamNetModel::HandleSliderMovingEnd (GdkEventButton* event)
   else
     {
       m_motion->Seek (m_scale.get_value());
+      SyncSecondView ();
     }
   return false;
 }
@@ -432,7 +793,12 @@ bool
 NamNetModel::ReadFromStream (Glib::RefPtr<Gio::DataInputStream> stream)
 {
   m_motion->LoadMotion (stream);
+  m_secondMotion->SetTrace (m_motion->GetTrace ());
   m_scale.set_range (0, m_motion->GetLastTime ());
+  m_secondScale.set_range (0, m_motion->GetLastTime ());
+  m_timeOffset = 0;
+  Gtk::Allocation allocation = m_scene.get_allocation ();
+  m_minimap->Update (allocation.get_width (), allocation.get_height ());
   return true;
 }
 
@@ -34,6 +34,7 @@
 #include "tree-models.h"
 #include "scene.h"
 #include "nam-net-motion.h"
+#include "nam-minimap.h"
 
 class NamNetModel : public NetModel
 {
@@ -57,6 +58,8 @@ private:
   void ZoomMotion (double time, double zoom);
   void CenterMotion (double time, const Point& center);
   void HandleSceneAlloc (Gtk::Allocation& allocation);
+  void HandleSceneResize (Gtk::Allocation& allocation);
+  bool HandleSceneButtonPress (GdkEventButton* event);
   void HandleSetZoom (void);
   bool HandleSceneRotate (enum Scene::MotionState state, double a1, double a2);
   bool HandleSceneMove (enum Scene::MotionState state, const Rectangle &rect);
@@ -73,6 +76,30 @@ private:
   void HandleZoomChanged (void);
   bool HandleZoomChange (double zoom);
   void HandleSpeedChanged (void);
+  void HandleColorModeChanged (void);
+  void HandleHeatmap (void);
+  void HandleExportSnapshot (void);
+  void HandleStatistics (void);
+  void HandleSplit (void);
+  void HandleLock (void);
+  bool HandleSecondScaleChange (Gtk::ScrollType scroll, double value);
+  void HandleSecondSceneAlloc (Gtk::Allocation& allocation);
+  void HandleSecondPlay (void);
+  void HandleSecondSpeedChanged (void);
+  void HandleSecondMotion (void);
+  void HandleSecondMotionState (const Motion *motion);
+  /**
+   * \brief fit the whole topology into the second view
+   */
+  void FitSecondScene (void);
+  /**
+   * \returns true if the second view is shown and follows the first one
+   */
+  bool IsSecondLocked (void) const;
+  /**
+   * \brief give a time locked second view the time, speed and play state of the first one
+   */
+  void SyncSecondView (void);
 
 private:
   typedef ColumnModel<Glib::ustring, double> StringDoubleModel;
@@ -83,15 +110,31 @@ private:
   Gtk::Label      m_speedLabel;
   Gtk::Entry      m_zoomEntry;
   Gtk::HScale     m_speedScale;
+  Gtk::HPaned     m_paned;
+  Gtk::VBox       m_secondBox;
+  Scene           m_secondScene;
+  Gtk::HScale     m_secondScale;
+  Gtk::CheckButton m_lockButton;
+  Gtk::ToggleButton m_secondPlayButton;
+  Gtk::Label      m_secondSpeedLabel;
+  Gtk::HScale     m_secondSpeedScale;
+  double          m_timeOffset; // time of the second view minus time of the first when locked
   Glib::RefPtr<ImageMotion>  m_moveMotion;
   Glib::RefPtr<ImageMotion>  m_rotateMotion;
   Glib::RefPtr<NamNetMotion> m_motion;
+  Glib::RefPtr<NamNetMotion> m_secondMotion; // shares the trace of m_motion
+  Glib::RefPtr<NamMinimap>   m_minimap;
   Glib::RefPtr<Animation> m_test;
   Gtk::ComboBoxEntry m_zoomCombo;
+  Gtk::ComboBoxText m_colorCombo;
+  Glib::RefPtr<Gtk::ToggleAction> m_heatmapAction;
+  Glib::RefPtr<Gtk::ToggleAction> m_statisticsAction;
+  Glib::RefPtr<Gtk::ToggleAction> m_splitAction;
   StringDoubleModel m_stringDoubleModel;
   std::vector<std::pair<Glib::ustring, double> > m_speedVector;
   sigc::connection m_motionStateConnection;
   sigc::connection m_allocConnection;
+  sigc::connection m_secondAllocConnection;
 };
 
 #endif /* NAM_NET_MODEL_H */
@@ -18,29 +18,154 @@
  * Author: Andrey Churin <aachurin@gmail.com>
  */
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
 
 #include "nam-net-motion.h"
 
+// number of intensity levels used by the occupancy renderer
+static const uint32_t LOD_LEVELS = 8;
+// above this number damaged rectangles are merged into their bounding box
+static const uint32_t MAX_DAMAGE_RECTS = 64;
+// number of colour levels used by the utilisation heatmap
+static const uint32_t HEAT_LEVELS = 8;
+// palette used by the flow, link and tag colour modes
+static const RgbaColor PALETTE[] =
+{
+  RgbaColor (0.12, 0.47, 0.71, 1),
+  RgbaColor (1.00, 0.50, 0.05, 1),
+  RgbaColor (0.17, 0.63, 0.17, 1),
+  RgbaColor (0.84, 0.15, 0.16, 1),
+  RgbaColor (0.58, 0.40, 0.74, 1),
+  RgbaColor (0.55, 0.34, 0.29, 1),
+  RgbaColor (0.89, 0.47, 0.76, 1),
+  RgbaColor (0.50, 0.50, 0.50, 1),
+  RgbaColor (0.74, 0.74, 0.13, 1),
+  RgbaColor (0.09, 0.75, 0.81, 1)
+};
+static const uint32_t PALETTE_SIZE = sizeof (PALETTE) / sizeof (PALETTE[0]);
+
+bool
+NamNetMotion::Bounds::Intersects (double x1, double y1, double x2, double y2, double width) const
+{
+  double margin = width / 2;
+  return std::max (x1, x2) + margin >= left && std::min (x1, x2) - margin <= right &&
+         std::max (y1, y2) + margin >= top && std::min (y1, y2) - margin <= bottom;
+}
+
+static void
+AddDamage (const Cairo::Matrix &matrix, double margin, const Point &from, const Point &to,
+  std::vector<Gdk::Rectangle> &rects)
+{
+  double x1 = from.x, y1 = from.y, x2 = to.x, y2 = to.y;
+  cairo_matrix_transform_point (&matrix, &x1, &y1);
+  cairo_matrix_transform_point (&matrix, &x2, &y2);
+
+  int left = (int)std::floor (std::min (x1, x2) - margin);
+  int top = (int)std::floor (std::min (y1, y2) - margin);
+  int right = (int)std::ceil (std::max (x1, x2) + margin);
+  int bottom = (int)std::ceil (std::max (y1, y2) + margin);
+
+  rects.push_back (Gdk::Rectangle (left, top, right - left, bottom - top));
+}
+
+NamNetMotion::Settings::Settings ()
+  : colorMode (COLOR_SINGLE),
+    heatmap (false),
+    heatmapWindow (0),
+    time (0),
+    edgeWidth (0),
+    nodeWidth (0),
+    packetWidth (0),
+    lodThreshold (0),
+    edgeColor (0, 0, 0, 0),
+    nodeColor (0, 0, 0, 0),
+    packetColor (0, 0, 0, 0),
+    degraded (false)
+{
+}
+
+NamNetMotion::Frame::Frame ()
+  : trace (0),
+    colorMode (COLOR_SINGLE),
+    serial (0),
+    time (0),
+    nextPacket (0),
+    geometry (PALETTE_SIZE)
+{
+}
+
+void
+NamNetMotion::Frame::Reset (void)
+{
+  time = 0;
+  nextPacket = 0;
+  for (GeometryVector::iterator i = geometry.begin (); i != geometry.end (); ++i)
+    {
+      (*i).Clear ();
+    }
+}
+
+void
+NamNetMotion::Frame::Swap (Frame &frame)
+{
+  std::swap (trace, frame.trace);
+  std::swap (colorMode, frame.colorMode);
+  std::swap (serial, frame.serial);
+  std::swap (time, frame.time);
+  std::swap (nextPacket, frame.nextPacket);
+  geometry.swap (frame.geometry);
+}
+
 NamNetMotion::NamNetMotion ()
-  : m_currentTime (0),
-    m_lastTime (0),
+  : m_trace (NamTrace::Create ()),
     m_speed (0),
     m_edgeWidth (0.005),
     m_nodeWidth (0.04),
     m_packetWidth (0.02),
+    m_lodThreshold (1.5),
+    m_degraded (false),
     m_edgeColor (0.5, 0.5, 0.5, 1),
     m_nodeColor (0.1, 0.1, 0.1, 1),
-    m_packetColor (0.0, 0.0, 1.0, 0.7)
+    m_packetColor (0.0, 0.0, 1.0, 0.7),
+    m_colorMode (COLOR_SINGLE),
+    m_heatmap (false),
+    m_heatmapWindow (1.0),
+    m_changes (0),
+    m_frameSerial (1),
+    m_packetGridSerial (0),
+    m_settingsSerial (1),
+    m_worker (0),
+    m_workerQuit (false),
+    m_workerBusy (false),
+    m_requested (false),
+    m_requestTime (0),
+    m_requestColorMode (COLOR_SINGLE),
+    m_requestSerial (0),
+    m_nextReady (0)
 {
+  m_settings.trace = m_trace;
+  m_settings.colorMode = m_colorMode;
+  m_settings.heatmap = m_heatmap;
+  m_settings.heatmapWindow = m_heatmapWindow;
+  m_settings.edgeWidth = m_edgeWidth;
+  m_settings.nodeWidth = m_nodeWidth;
+  m_settings.packetWidth = m_packetWidth;
+  m_settings.lodThreshold = m_lodThreshold;
+  m_settings.edgeColor = m_edgeColor;
+  m_settings.nodeColor = m_nodeColor;
+  m_settings.packetColor = m_packetColor;
+  m_frame.trace = m_trace.operator-> ();
+  m_frame.serial = m_settingsSerial;
   SetVisual (true);
-  m_packetIt = m_packets.begin ();
 }
 
 NamNetMotion::~NamNetMotion ()
 {
+  SetPipelined (false);
 }
 
 Glib::RefPtr<NamNetMotion>
@@ -52,184 +177,687 @@ NamNetMotion::Create (void)
 void
 NamNetMotion::EnterFrame (uint32_t rate)
 {
-  double time = m_currentTime + m_speed / rate;
+  EnterFrames (rate, 1);
+}
 
-  if (time > m_lastTime)
+void
+NamNetMotion::EnterFrames (uint32_t rate, uint32_t count)
+{
+  // frames skipped by the manager are entered as one step
+  double step = count * m_speed / rate;
+  double time = m_frame.time + step;
+
+  if (time > m_trace->GetLastTime ())
     {
       Stop ();
       return;
     }
 
-  m_currentTime = time;
-  // add packets to the buffer
-  while (m_packetIt != m_packets.end ())
+  // take the frame the worker has prepared if it is the one due now,
+  // the worker doesn't touch m_next once it has been marked ready
+  bool ready = m_worker && g_atomic_int_get (&m_nextReady);
+  bool current = ready && m_next.serial == m_frame.serial;
+  if (current && m_next.time == time)
+    {
+      m_frame.Swap (m_next);
+      g_atomic_int_set (&m_nextReady, 0);
+    }
+  else
+    {
+      UpdateBuffer (m_frame, time);
+      // a frame prepared for a later time stays ready, e.g. after a seek back
+      if (ready && (!current || m_next.time <= time))
+        {
+          g_atomic_int_set (&m_nextReady, 0);
+        }
+    }
+
+  if (m_worker)
     {
-      if ((*m_packetIt).fbTx > time) break;// in the future
-      m_packetBuffer.push_back (*m_packetIt);
-      m_packetIt++;
+      // a degraded motion keeps entering steps of the same length
+      RequestFrame (time + step);
     }
 
+  UpdateUtilisation ();
+  m_frameSerial++;
+
   Motion::EnterFrame (rate);
 }
 
 void
 NamNetMotion::DrawFrame (const Cairo::RefPtr<Cairo::Context> &context)
 {
+  // Only the geometry within the clip is drawn, e.g. one tile of the frame
+  Bounds clip;
+  cairo_clip_extents (context->cobj (), &clip.left, &clip.top, &clip.right, &clip.bottom);
+
   // draw links
+  const NamTopology &t = m_trace->GetTopology ();
+
   context->save ();
   context->set_line_cap (Cairo::LINE_CAP_ROUND);
   context->set_line_width (m_edgeWidth);
-  context->set_source_rgba (m_edgeColor.r, m_edgeColor.g, m_edgeColor.b, m_edgeColor.a);
-  for (EdgeVector::const_iterator i = m_edges.begin (); i != m_edges.end (); ++i)
+  if (m_heatmap)
+    {
+      DrawHeatmap (context, clip);
+    }
+  else
+    {
+      context->set_source_rgba (m_edgeColor.r, m_edgeColor.g, m_edgeColor.b, m_edgeColor.a);
+      for (uint32_t j = 0; j < t.GetLinkCount (); ++j)
+        {
+          double x1 = t.nodeX[t.linkFrom[j]], y1 = t.nodeY[t.linkFrom[j]];
+          double x2 = t.nodeX[t.linkTo[j]], y2 = t.nodeY[t.linkTo[j]];
+          if (clip.Intersects (x1, y1, x2, y2, m_edgeWidth))
+            {
+              context->move_to (x1, y1);
+              context->line_to (x2, y2);
+            }
+        }
+      context->stroke ();
+    }
+
+  // Scene::ApplyTransformation scales the context by the scene scale and zoom,
+  // so the device length of a unit vector is the current pixels per unit.
+  double dx = 1.0, dy = 0.0;
+  context->user_to_device_distance (dx, dy);
+
+  if (UseOccupancy (std::sqrt (dx * dx + dy * dy)))
+    {
+      DrawOccupancy (context, clip);
+    }
+  else
+    {
+      DrawPackets (context, clip);
+    }
+
+  // draw nodes
+  double delta = m_nodeWidth / 2;
+  context->set_source_rgba (m_nodeColor.r, m_nodeColor.g, m_nodeColor.b, m_nodeColor.a);
+  for (uint32_t i = 0; i < t.GetNodeCount (); ++i)
+    {
+      double x = t.nodeX[i];
+      double y = t.nodeY[i];
+      if (clip.Intersects (x, y, x, y, m_nodeWidth))
+        {
+          context->rectangle (x - delta, y - delta, m_nodeWidth, m_nodeWidth);
+        }
+    }
+
+  context->fill ();
+
+  context->restore ();
+}
+
+// distance between point and segment
+static double
+GetDistance (double x, double y, const Point &from, const Point &to)
+{
+  double dx = to.x - from.x;
+  double dy = to.y - from.y;
+  double length = dx * dx + dy * dy;
+  double u = length > 0 ? ((x - from.x) * dx + (y - from.y) * dy) / length : 0;
+  u = std::max (0.0, std::min (1.0, u));
+  return std::sqrt ((from.x + u * dx - x) * (from.x + u * dx - x) + (from.y + u * dy - y) * (from.y + u * dy - y));
+}
+
+bool
+NamNetMotion::Pick (double x, double y, double tolerance, Glib::ustring &info)
+{
+  // the frame is only changed on the GTK thread, reading it needs no lock
+  const NamTopology &t = m_trace->GetTopology ();
+  std::vector<uint32_t> items;
+  double best = tolerance;
+  bool found = false;
+
+  // nodes are drawn on top of packets, packets on top of links
+  double reach = tolerance + m_nodeWidth / 2;
+  m_trace->GetNodeGrid ().Query (x - reach, y - reach, x + reach, y + reach, items);
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); ++i)
+    {
+      double distance = std::max (std::fabs (t.nodeX[*i] - x), std::fabs (t.nodeY[*i] - y)) - m_nodeWidth / 2;
+      if (distance <= best)
+        {
+          best = distance;
+          found = true;
+          info = Glib::ustring::compose ("Node %1\n(%2, %3)", t.nodeId[*i], t.nodeX[*i], t.nodeY[*i]);
+        }
+    }
+  if (found)
+    {
+      return true;
+    }
+
+  if (m_packetGridSerial != m_frameSerial)
+    {
+      BuildPacketIndex ();
+    }
+  items.clear ();
+  reach = tolerance + m_packetWidth / 2;
+  m_packetGrid.Query (x - reach, y - reach, x + reach, y + reach, items);
+  const PacketVector &packets = m_trace->GetPackets ();
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); ++i)
+    {
+      const PacketGeometry &g = m_frame.geometry[m_packetRefs[*i].first];
+      uint32_t j = m_packetRefs[*i].second;
+      double distance = GetDistance (x, y, Point (g.x1[j], g.y1[j]), Point (g.x2[j], g.y2[j])) - m_packetWidth / 2;
+      if (distance <= best)
+        {
+          const Packet &packet = packets[g.id[j]];
+          uint32_t origin = t.linkFrom[packet.GetLink ()];
+          uint32_t target = t.linkTo[packet.GetLink ()];
+          if (packet.GetDirection ())
+            {
+              std::swap (origin, target);
+            }
+          best = distance;
+          found = true;
+          info = Glib::ustring::compose ("Packet %1 -> %2\nTx %3 - %4\nRx %5 - %6",
+                                         t.nodeId[origin], t.nodeId[target],
+                                         packet.GetFirstBitTx (), packet.GetLastBitTx (),
+                                         packet.GetFirstBitRx (), packet.GetLastBitRx ());
+        }
+    }
+  if (found)
+    {
+      return true;
+    }
+
+  items.clear ();
+  reach = tolerance + m_edgeWidth / 2;
+  m_trace->GetEdgeGrid ().Query (x - reach, y - reach, x + reach, y + reach, items);
+  for (std::vector<uint32_t>::const_iterator i = items.begin (); i != items.end (); ++i)
+    {
+      uint32_t from = t.linkFrom[*i];
+      uint32_t to = t.linkTo[*i];
+      double distance = GetDistance (x, y, Point (t.nodeX[from], t.nodeY[from]), Point (t.nodeX[to], t.nodeY[to])) - m_edgeWidth / 2;
+      if (distance <= best)
+        {
+          best = distance;
+          found = true;
+          info = Glib::ustring::compose ("Link %1 - %2", t.nodeId[from], t.nodeId[to]);
+        }
+    }
+  return found;
+}
+
+void
+NamNetMotion::GetStatistics (const Cairo::Matrix &matrix, int width, int height, Glib::ustring &text) const
+{
+  Cairo::Matrix inverse = matrix;
+  if (cairo_matrix_invert (&inverse) != CAIRO_STATUS_SUCCESS)
     {
-      context->move_to ((*i).n1->x, (*i).n1->y);
-      context->line_to ((*i).n2->x, (*i).n2->y);
+      return;
     }
-  context->stroke ();
 
-  context->set_source_rgba (m_packetColor.r, m_packetColor.g, m_packetColor.b, m_packetColor.a);
+  // user space bounding box of the visible area
+  Bounds view;
+  for (int i = 0; i < 4; ++i)
+    {
+      double x = (i == 1 || i == 2) ? width : 0;
+      double y = (i >= 2) ? height : 0;
+      cairo_matrix_transform_point (&inverse, &x, &y);
+      view.left = i ? std::min (view.left, x) : x;
+      view.top = i ? std::min (view.top, y) : y;
+      view.right = i ? std::max (view.right, x) : x;
+      view.bottom = i ? std::max (view.bottom, y) : y;
+    }
+
+  uint32_t active = 0, drawn = 0;
+  for (GeometryVector::const_iterator g = m_frame.geometry.begin (); g != m_frame.geometry.end (); ++g)
+    {
+      for (uint32_t j = 0; j < (*g).GetSize (); ++j)
+        {
+          if ((*g).visible[j])
+            {
+              active++;
+              if (view.Intersects ((*g).x1[j], (*g).y1[j], (*g).x2[j], (*g).y2[j], m_packetWidth))
+                {
+                  drawn++;
+                }
+            }
+        }
+    }
+
+  bool occupancy = UseOccupancy (std::sqrt (matrix.xx * matrix.xx + matrix.yx * matrix.yx));
+  text += Glib::ustring::compose ("packets: %1 active, %2 drawn, %3 culled%4\n", active, drawn, active - drawn,
+    occupancy ? " (as occupancy)" : "");
+}
+
+void
+NamNetMotion::BuildPacketIndex (void)
+{
+  const Rectangle &extent = m_trace->GetExtent ();
+  uint32_t count = 0;
+  for (uint32_t c = 0; c < PALETTE_SIZE; ++c)
+    {
+      count += m_frame.geometry[c].GetSize ();
+    }
+
+  m_packetRefs.clear ();
+  m_packetGrid.Reset (extent.left, extent.top, extent.right, extent.bottom, count);
+  for (uint32_t c = 0; c < PALETTE_SIZE; ++c)
+    {
+      const PacketGeometry &g = m_frame.geometry[c];
+      for (uint32_t j = 0; j < g.GetSize (); ++j)
+        {
+          if (g.visible[j])
+            {
+              m_packetGrid.AddSegment (m_packetRefs.size (), g.x1[j], g.y1[j], g.x2[j], g.y2[j]);
+              m_packetRefs.push_back (std::make_pair (c, j));
+            }
+        }
+    }
+  m_packetGrid.Finalize ();
+  m_packetGridSerial = m_frameSerial;
+}
+
+bool
+NamNetMotion::UseOccupancy (double scale) const
+{
+  return m_degraded || m_packetWidth * scale < m_lodThreshold;
+}
+
+void
+NamNetMotion::Degrade (uint32_t level)
+{
+  // called by the manager on the GTK thread, while the frame may be drawn
+  m_settings.degraded = level > 0;
+  RequestChange (CHANGE_DEGRADATION);
+}
+
+void
+NamNetMotion::DrawHeatmap (const Cairo::RefPtr<Cairo::Context> &context, const Bounds &clip) const
+{
+  const NamTopology &t = m_trace->GetTopology ();
+
+  // one stroke per utilisation level, from the link color to red
+  for (uint32_t level = 0; level < HEAT_LEVELS; ++level)
+    {
+      bool drawn = false;
+      for (uint32_t i = 0; i < t.GetLinkCount (); ++i)
+        {
+          uint32_t bucket = std::min (HEAT_LEVELS - 1, (uint32_t)(m_utilisation[i] * HEAT_LEVELS));
+          double x1 = t.nodeX[t.linkFrom[i]], y1 = t.nodeY[t.linkFrom[i]];
+          double x2 = t.nodeX[t.linkTo[i]], y2 = t.nodeY[t.linkTo[i]];
+          if (bucket == level && clip.Intersects (x1, y1, x2, y2, m_edgeWidth))
+            {
+              context->move_to (x1, y1);
+              context->line_to (x2, y2);
+              drawn = true;
+            }
+        }
+
+      if (drawn)
+        {
+          double heat = (double)level / (HEAT_LEVELS - 1);
+          context->set_source_rgba (m_edgeColor.r + (1.0 - m_edgeColor.r) * heat,
+                                    m_edgeColor.g * (1.0 - heat),
+                                    m_edgeColor.b * (1.0 - heat),
+                                    m_edgeColor.a);
+          context->stroke ();
+        }
+    }
+}
+
+void
+NamNetMotion::UpdateUtilisation (void)
+{
+  if (!m_heatmap)
+    {
+      return;
+    }
+
+  double from = std::max (0.0, m_frame.time - m_heatmapWindow);
+  double window = m_frame.time - from;
+
+  for (uint32_t i = 0; i < m_utilisation.size (); ++i)
+    {
+      float utilisation = 0;
+      for (uint32_t s = 2 * i; s < 2 * i + 2 && window > 0; ++s)
+        {
+          double busy = m_trace->GetBusyTime (s, m_frame.time, m_headCursors[s]) -
+            m_trace->GetBusyTime (s, from, m_tailCursors[s]);
+          utilisation = std::max (utilisation, (float)(busy / window));
+        }
+      m_utilisation[i] = utilisation;
+    }
+}
+
+void
+NamNetMotion::DrawPackets (const Cairo::RefPtr<Cairo::Context> &context, const Bounds &clip) const
+{
   context->set_line_cap (Cairo::LINE_CAP_BUTT);
   context->set_line_width (m_packetWidth);
 
-  PacketList::iterator i = m_packetBuffer.begin();
-  while (i != m_packetBuffer.end())
+  // The geometry is kept per palette index, so that every colour
+  // costs a single source change and a single stroke.
+  for (uint32_t c = 0; c < PALETTE_SIZE; ++c)
     {
-      if ((*i).lbRx <= m_currentTime || (*i).fbTx > m_currentTime) // In the past or in the future
+      const PacketGeometry &g = m_frame.geometry[c];
+      bool drawn = false;
+      for (uint32_t j = 0; j < g.GetSize (); ++j)
         {
-          i = m_packetBuffer.erase (i);
-          continue;
+          if (g.visible[j] && clip.Intersects (g.x1[j], g.y1[j], g.x2[j], g.y2[j], m_packetWidth))
+            {
+              context->move_to (g.x1[j], g.y1[j]);
+              context->line_to (g.x2[j], g.y2[j]);
+              drawn = true;
+            }
         }
 
-      Packet pkt = *i;
-      context->save ();
-      const Edge *edge = pkt.edge;
-      if (pkt.direction == 0)
+      if (drawn)
         {
-          context->translate (edge->n1->x, edge->n1->y);
-          context->rotate (edge->angle);
+          RgbaColor color = GetPaletteColor (c);
+          context->set_source_rgba (color.r, color.g, color.b, color.a);
+          context->stroke ();
         }
-      else
+    }
+}
+
+uint16_t
+NamNetMotion::GetColorIndex (const Packet &packet, uint32_t tag, ColorMode mode)
+{
+  uint32_t key;
+  switch (mode)
+    {
+    case COLOR_BY_FLOW:
+      key = packet.GetSeries ();
+      break;
+    case COLOR_BY_LINK:
+      key = packet.GetLink ();
+      break;
+    case COLOR_BY_TAG:
+      key = tag;
+      break;
+    default:
+      return 0;
+    }
+
+  return key % PALETTE_SIZE;
+}
+
+RgbaColor
+NamNetMotion::GetPaletteColor (uint16_t index) const
+{
+  if (m_colorMode == COLOR_SINGLE)
+    {
+      return m_packetColor;
+    }
+
+  // palette colours share the transparency of the packet color
+  RgbaColor color = PALETTE[index];
+  color.a = m_packetColor.a;
+  return color;
+}
+
+void
+NamNetMotion::DrawOccupancy (const Cairo::RefPtr<Cairo::Context> &context, const Bounds &clip) const
+{
+  const NamTopology &t = m_trace->GetTopology ();
+  uint32_t maxCount = 0;
+  CounterVector occupancy (t.GetLinkCount () * 2, 0); // active packets per link and direction
+
+  const PacketVector &packets = m_trace->GetPackets ();
+  for (GeometryVector::const_iterator g = m_frame.geometry.begin (); g != m_frame.geometry.end (); ++g)
+    {
+      for (uint32_t j = 0; j < (*g).GetSize (); ++j)
         {
-          context->translate (edge->n2->x, edge->n2->y);
-          context->rotate (edge->angle + M_PI);
+          if (!(*g).visible[j]) // In the past or in the future
+            {
+              continue;
+            }
+
+          uint32_t &count = occupancy[packets[(*g).id[j]].GetSeries ()];
+          if (++count > maxCount)
+            {
+              maxCount = count;
+            }
         }
+    }
 
-      // Compute packet transmission time
-      double txTime = pkt.lbTx - pkt.fbTx;
+  if (maxCount == 0)
+    {
+      return;
+    }
 
-      // Adujst if last bit not yet transmitted
-      if (pkt.lbTx > m_currentTime) txTime = m_currentTime - pkt.fbTx;
-      // Adjust if first bit already received
-      if (pkt.fbRx < m_currentTime) txTime -= m_currentTime - pkt.fbRx;
+  // Turn counters into intensity levels, so that each level costs a single stroke
+  for (CounterVector::iterator j = occupancy.begin (); j != occupancy.end (); ++j)
+    {
+      *j = ((*j) * LOD_LEVELS + maxCount - 1) / maxCount;
+    }
 
-      // Propagation delay
-      double delay = pkt.fbRx - pkt.fbTx;
+  // Each direction gets its own half of the packet width
+  double offset = m_packetWidth / 4;
+  context->set_line_cap (Cairo::LINE_CAP_BUTT);
+  context->set_line_width (m_packetWidth / 2);
 
-      // Compute last bit distance from transmitter
-      double lbTime = m_currentTime - pkt.lbTx; // Relative to current time
+  for (uint32_t level = 1; level <= LOD_LEVELS; level++)
+    {
+      for (uint32_t j = 0; j < occupancy.size (); j++)
+        {
+          uint32_t link = j / 2;
+          double x1 = t.nodeX[t.linkFrom[link]], y1 = t.nodeY[t.linkFrom[link]];
+          double x2 = t.nodeX[t.linkTo[link]], y2 = t.nodeY[t.linkTo[link]];
+          if (occupancy[j] != level || t.linkLength[link] <= 0 ||
+              !clip.Intersects (x1, y1, x2, y2, m_packetWidth))
+            {
+              continue;
+            }
 
-      if (lbTime < 0) lbTime = 0;
+          // normal of the link direction
+          double side = (j % 2 == 0) ? offset : -offset;
+          double nx = -t.linkSin[link] * side;
+          double ny = t.linkCos[link] * side;
+          context->move_to (x1 + nx, y1 + ny);
+          context->line_to (x2 + nx, y2 + ny);
+        }
 
-      double pktWidth = edge->distance * txTime / delay;
+      double alpha = m_packetColor.a * level / LOD_LEVELS;
+      context->set_source_rgba (m_packetColor.r, m_packetColor.g, m_packetColor.b, alpha);
+      context->stroke ();
+    }
+}
 
-      //if (pktWidth > 4) pktWidth -= 4; // Some spacing between pkts
+void
+NamNetMotion::GetHop (const NamTopology &t, const Packet &packet, double &x, double &y, double &dx, double &dy)
+{
+  uint32_t link = packet.GetLink ();
+  uint32_t origin = t.linkFrom[link];
+  dx = t.linkCos[link] * t.linkLength[link];
+  dy = t.linkSin[link] * t.linkLength[link];
+  if (packet.GetDirection () != 0)
+    {
+      origin = t.linkTo[link];
+      dx = -dx;
+      dy = -dy;
+    }
+  x = t.nodeX[origin];
+  y = t.nodeY[origin];
+}
 
-      double pktDist = edge->distance * lbTime / delay;
+bool
+NamNetMotion::GetPacketSegment (const Packet &pkt, double time, Point &from, Point &to) const
+{
+  double fbTx = pkt.GetFirstBitTx ();
+  double lbRx = pkt.GetLastBitRx ();
+  if (lbRx <= time || fbTx > time) // In the past or in the future
+    {
+      return false;
+    }
 
-      context->move_to (pktDist, 0);
-      context->line_to (pktDist + pktWidth, 0);
-      context->stroke ();
+  double lbTx = pkt.GetLastBitTx ();
+  double fbRx = pkt.GetFirstBitRx ();
+  double x, y, dx, dy;
+  GetHop (m_trace->GetTopology (), pkt, x, y, dx, dy);
+
+  // Compute packet transmission time
+  double txTime = lbTx - fbTx;
+
+  // Adujst if last bit not yet transmitted
+  if (lbTx > time) txTime = time - fbTx;
+  // Adjust if first bit already received
+  if (fbRx < time) txTime -= time - fbRx;
 
-      context->restore();
+  // Propagation delay
+  double delay = fbRx - fbTx;
 
-      ++i;
+  // Compute last bit distance from transmitter
+  double lbTime = time - lbTx; // Relative to current time
+
+  if (lbTime < 0) lbTime = 0;
+
+  // Both distances are fractions of the link length
+  double pktDist = lbTime / delay;
+  double pktEnd = pktDist + txTime / delay;
+
+  from = Point (x + dx * pktDist, y + dy * pktDist);
+  to = Point (x + dx * pktEnd, y + dy * pktEnd);
+  return true;
+}
+
+bool
+NamNetMotion::GetDamage (const Cairo::Matrix &matrix, uint32_t rate, Gdk::Region &region)
+{
+  if (!IsStarted ())
+    {
+      return true;
     }
 
-  // draw nodes
-  double delta = m_nodeWidth / 2;
-  context->set_source_rgba (m_nodeColor.r, m_nodeColor.g, m_nodeColor.b, m_nodeColor.a);
-  for (NodeMap::const_iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+  // Occupancy levels are relative to the busiest link, so any packet may change all of them;
+  // the same holds for the heatmap and the links
+  if (m_heatmap || UseOccupancy (std::sqrt (matrix.xx * matrix.xx + matrix.yx * matrix.yx)))
     {
-      double x = (*i).second.x;
-      double y = (*i).second.y;
-      context->rectangle ((*i).second.x - delta, y - delta, m_nodeWidth, m_nodeWidth);
+      return false;
     }
 
-  context->fill ();
+  double next = m_frame.time + m_speed / rate;
+  double margin = m_packetWidth / 2 * std::sqrt (matrix.xx * matrix.xx + matrix.yx * matrix.yx) + 1.0;
+  std::vector<Gdk::Rectangle> rects;
+  Point from, to;
 
-  context->restore ();
+  // packets which move or vanish, read from the vertex buffer
+  for (GeometryVector::const_iterator g = m_frame.geometry.begin (); g != m_frame.geometry.end (); ++g)
+    {
+      for (uint32_t j = 0; j < (*g).GetSize (); ++j)
+        {
+          if ((*g).visible[j])
+            {
+              AddDamage (matrix, margin, Point ((*g).x1[j], (*g).y1[j]), Point ((*g).x2[j], (*g).y2[j]), rects);
+            }
+          if ((*g).GetSegment (j, next, from, to))
+            {
+              AddDamage (matrix, margin, from, to, rects);
+            }
+        }
+    }
+
+  // packets which appear
+  const PacketVector &packets = m_trace->GetPackets ();
+  for (PacketVector::const_iterator i = packets.begin () + m_frame.nextPacket; i != packets.end () && (*i).GetFirstBitTx () <= next; ++i)
+    {
+      if (GetPacketSegment (*i, next, from, to))
+        {
+          AddDamage (matrix, margin, from, to, rects);
+        }
+    }
+
+  if (rects.size () > MAX_DAMAGE_RECTS)
+    {
+      Gdk::Rectangle bounds = rects.front ();
+      for (std::vector<Gdk::Rectangle>::const_iterator i = rects.begin (); i != rects.end (); ++i)
+        {
+          bounds.join (*i);
+        }
+      region.union_with_rect (bounds);
+    }
+  else
+    {
+      for (std::vector<Gdk::Rectangle>::const_iterator i = rects.begin (); i != rects.end (); ++i)
+        {
+          region.union_with_rect (*i);
+        }
+    }
+
+  return true;
 }
 
 void
 NamNetMotion::SetEdgeWidth (double width)
 {
-  m_edgeWidth = width;
+  m_settings.edgeWidth = width;
+  RequestChange (CHANGE_STYLE);
 }
 
 double
 NamNetMotion::GetEdgeWidth (void) const
 {
-  return m_edgeWidth;
+  return m_settings.edgeWidth;
 }
 
 void
 NamNetMotion::SetEdgeColor (const RgbaColor &color)
 {
-  m_edgeColor = color;
+  m_settings.edgeColor = color;
+  RequestChange (CHANGE_STYLE);
 }
 
 RgbaColor
 NamNetMotion::GetEdgeColor (void) const
 {
-  return m_edgeColor;
+  return m_settings.edgeColor;
 }
 
 void
 NamNetMotion::SetNodeWidth (double width)
 {
-  m_nodeWidth = width;
+  m_settings.nodeWidth = width;
+  RequestChange (CHANGE_STYLE);
 }
 
 double
 NamNetMotion::GetNodeWidth (void) const
 {
-  return m_nodeWidth;
+  return m_settings.nodeWidth;
 }
 
 void
 NamNetMotion::SetNodeColor (const RgbaColor &color)
 {
-  m_nodeColor = color;
+  m_settings.nodeColor = color;
+  RequestChange (CHANGE_STYLE);
 }
 
 RgbaColor
 NamNetMotion::GetNodeColor (void) const
 {
-  return m_nodeColor;
+  return m_settings.nodeColor;
 }
 
 void
 NamNetMotion::SetPacketWidth (double width)
 {
-  m_packetWidth = width;
+  m_settings.packetWidth = width;
+  RequestChange (CHANGE_STYLE);
 }
 
 double
 NamNetMotion::GetPacketWidth (void) const
 {
-  return m_packetWidth;
+  return m_settings.packetWidth;
 }
 
 void
 NamNetMotion::SetPacketColor (const RgbaColor &color)
 {
-  m_packetColor = color;
+  m_settings.packetColor = color;
+  RequestChange (CHANGE_STYLE);
 }
 
 RgbaColor
 NamNetMotion::GetPacketColor (void) const
 {
-  return m_packetColor;
+  return m_settings.packetColor;
 }
 
 void
@@ -244,46 +872,281 @@ NamNetMotion::GetMotionSpeed (void) const
   return m_speed;
 }
 
+void
+NamNetMotion::SetLodThreshold (double pixels)
+{
+  m_settings.lodThreshold = pixels;
+  RequestChange (CHANGE_STYLE);
+}
+
+double
+NamNetMotion::GetLodThreshold (void) const
+{
+  return m_settings.lodThreshold;
+}
+
+void
+NamNetMotion::SetColorMode (ColorMode mode)
+{
+  m_settings.colorMode = mode;
+  RequestChange (CHANGE_COLOR_MODE);
+}
+
+NamNetMotion::ColorMode
+NamNetMotion::GetColorMode (void) const
+{
+  return m_settings.colorMode;
+}
+
+void
+NamNetMotion::SetHeatmap (bool enable)
+{
+  m_settings.heatmap = enable;
+  RequestChange (CHANGE_HEATMAP);
+}
+
+bool
+NamNetMotion::IsHeatmap (void) const
+{
+  return m_settings.heatmap;
+}
+
+void
+NamNetMotion::SetHeatmapWindow (double window)
+{
+  m_settings.heatmapWindow = window;
+  RequestChange (CHANGE_HEATMAP);
+}
+
+double
+NamNetMotion::GetHeatmapWindow (void) const
+{
+  return m_settings.heatmapWindow;
+}
+
 double
 NamNetMotion::GetCurrentTime (void) const
 {
-  return m_currentTime;
+  return (m_changes & CHANGE_TIME) ? m_settings.time : m_frame.time;
 }
 
 double
 NamNetMotion::GetLastTime (void) const
 {
-  return m_lastTime;
+  return m_settings.trace->GetLastTime ();
 }
 
 void
 NamNetMotion::Seek (double time)
 {
-  m_packetBuffer.clear ();
-  PacketVector::iterator it = m_packets.begin ();
-  while (it != m_packets.end ())
+  m_settings.time = std::max (0.0, std::min (time, m_settings.trace->GetLastTime ()));
+  RequestChange (CHANGE_TIME);
+}
+
+void
+NamNetMotion::RequestChange (uint32_t change)
+{
+  m_changes |= change;
+  // never wait for the render thread, it holds the mutex for whole frames
+  if (m_frameMutex.trylock ())
     {
-      if ((*it).fbTx > time) break;
-      if ((*it).lbRx >= time)
+      ApplyChanges ();
+      m_frameMutex.unlock ();
+    }
+}
+
+bool
+NamNetMotion::ApplyChanges (void)
+{
+  uint32_t changes = m_changes;
+
+  if (changes == 0)
+    {
+      return false;
+    }
+  m_changes = 0;
+
+  if (changes & CHANGE_TRACE)
+    {
+      m_trace = m_settings.trace;
+      uint32_t series = 2 * m_trace->GetTopology ().GetLinkCount ();
+      m_headCursors.resize (series);
+      for (uint32_t i = 0; i < series; ++i)
+        {
+          m_headCursors[i] = m_trace->GetBusyCursor (i);
+        }
+      m_tailCursors = m_headCursors;
+      m_utilisation.assign (m_trace->GetTopology ().GetLinkCount (), 0);
+      m_packetGridSerial = 0;
+    }
+  m_colorMode = m_settings.colorMode;
+  m_heatmap = m_settings.heatmap;
+  m_heatmapWindow = m_settings.heatmapWindow;
+  m_degraded = m_settings.degraded;
+  if (changes & CHANGE_STYLE)
+    {
+      m_edgeWidth = m_settings.edgeWidth;
+      m_nodeWidth = m_settings.nodeWidth;
+      m_lodThreshold = m_settings.lodThreshold;
+      m_edgeColor = m_settings.edgeColor;
+      m_nodeColor = m_settings.nodeColor;
+      m_packetColor = m_settings.packetColor;
+      if (m_packetWidth != m_settings.packetWidth)
         {
-          m_packetBuffer.push_back (*it);
+          // the packet pick grid was built with the old width
+          m_packetWidth = m_settings.packetWidth;
+          m_packetGridSerial = 0;
         }
-      it++;
     }
 
-  m_packetIt = it;
+  if (changes & (CHANGE_TRACE | CHANGE_COLOR_MODE | CHANGE_TIME))
+    {
+      double time = (changes & CHANGE_TIME) ? m_settings.time : m_frame.time;
+      if (changes & (CHANGE_TRACE | CHANGE_COLOR_MODE))
+        {
+          // packets are coloured when they enter the buffer, refill it;
+          // the new serial makes a frame the worker prepares now stale
+          m_frame.Reset ();
+          m_frame.trace = m_trace.operator-> ();
+          m_frame.colorMode = m_colorMode;
+          m_frame.serial = ++m_settingsSerial;
+        }
+      UpdateBuffer (m_frame, time);
+      m_frameSerial++;
+    }
+  UpdateUtilisation ();
+  return true;
+}
 
-  if (time > m_lastTime)
+void
+NamNetMotion::UpdateBuffer (Frame &frame, double time) const
+{
+  // the buffer only grows forward
+  if (time < frame.time)
     {
-      m_currentTime = m_lastTime;
+      frame.Reset ();
     }
-  else if (time < 0)
+  frame.time = time;
+
+  // remove packets which have been received, keeping the order
+  for (GeometryVector::iterator i = frame.geometry.begin (); i != frame.geometry.end (); ++i)
     {
-      m_currentTime = 0;
+      (*i).RemoveReceived (time);
     }
-  else
+
+  // packets before the time index are all received, long jumps skip them
+  const PacketVector &packets = frame.trace->GetPackets ();
+  const NamTopology &t = frame.trace->GetTopology ();
+  frame.nextPacket = std::max (frame.nextPacket, frame.trace->FindPacket (time));
+
+  // append admitted packets to the geometry of their colour, which keeps
+  // every colour in trace order without sorting
+  for (; frame.nextPacket < packets.size (); ++frame.nextPacket)
+    {
+      const Packet &packet = packets[frame.nextPacket];
+      if (packet.GetFirstBitTx () > time) break; // in the future
+      if (packet.GetLastBitRx () > time)
+        {
+          double x, y, dx, dy;
+          GetHop (t, packet, x, y, dx, dy);
+          uint16_t color = GetColorIndex (packet, frame.trace->GetTag (frame.nextPacket), frame.colorMode);
+          frame.geometry[color].Add (packet, x, y, dx, dy, frame.nextPacket);
+        }
+    }
+
+  for (GeometryVector::iterator i = frame.geometry.begin (); i != frame.geometry.end (); ++i)
+    {
+      (*i).Compute (time);
+    }
+}
+
+void
+NamNetMotion::SetPipelined (bool enable)
+{
+  if (enable == (m_worker != 0))
+    {
+      return;
+    }
+
+  if (enable)
+    {
+      m_workerQuit = false;
+      m_worker = Glib::Thread::create (sigc::mem_fun (*this, &NamNetMotion::RunWorker), true);
+      return;
+    }
+
+  {
+    Glib::Mutex::Lock lock (m_workerMutex);
+    m_workerQuit = true;
+    m_workerCond.signal ();
+  }
+  m_worker->join ();
+  m_worker = 0;
+  g_atomic_int_set (&m_nextReady, 0);
+}
+
+bool
+NamNetMotion::IsPipelined (void) const
+{
+  return m_worker != 0;
+}
+
+void
+NamNetMotion::RequestFrame (double time)
+{
+  // never wait for the worker, a frame it misses is prepared in EnterFrame
+  if (!m_workerMutex.trylock ())
+    {
+      return;
+    }
+
+  bool ready = g_atomic_int_get (&m_nextReady);
+  if (!m_workerBusy && !(ready && m_next.serial == m_frame.serial && m_next.time == time))
+    {
+      // m_next belongs to the worker again until it is marked ready
+      g_atomic_int_set (&m_nextReady, 0);
+      m_requestTime = time;
+      m_requestTrace = m_trace;
+      m_requestColorMode = m_frame.colorMode;
+      m_requestSerial = m_frame.serial;
+      m_requested = true;
+      m_workerCond.signal ();
+    }
+  m_workerMutex.unlock ();
+}
+
+void
+NamNetMotion::RunWorker (void)
+{
+  Glib::Mutex::Lock lock (m_workerMutex);
+  while (!m_workerQuit)
     {
-      m_currentTime = time;
+      if (!m_requested)
+        {
+          m_workerCond.wait (m_workerMutex);
+          continue;
+        }
+
+      // The request fields and m_requestTrace don't change while the worker
+      // is busy, so m_next is prepared without holding the mutex.
+      m_requested = false;
+      m_workerBusy = true;
+      double time = m_requestTime;
+      lock.release ();
+
+      if (m_next.serial != m_requestSerial)
+        {
+          m_next.Reset ();
+          m_next.trace = m_requestTrace.operator-> ();
+          m_next.colorMode = m_requestColorMode;
+          m_next.serial = m_requestSerial;
+        }
+      // m_next is two frames behind after a swap, it only moves forward
+      UpdateBuffer (m_next, time);
+      g_atomic_int_set (&m_nextReady, 1);
+
+      lock.acquire ();
+      m_workerBusy = false;
     }
 }
 
@@ -291,109 +1154,56 @@ std::vector<Node>
 NamNetMotion::GetNodes (void) const
 {
   std::vector<Node> result;
-  for (NodeMap::const_iterator i = m_nodes.begin (); i != m_nodes.end (); ++i)
+  const NodeMap &nodes = m_settings.trace->GetNodes ();
+  for (NodeMap::const_iterator i = nodes.begin (); i != nodes.end (); ++i)
     {
       result.push_back ((*i).second);
     }
   return result;
 }
 
+const std::vector<Edge> &
+NamNetMotion::GetEdges (void) const
+{
+  return m_trace->GetEdges ();
+}
+
+void
+NamNetMotion::GetOccupancy (std::vector<uint32_t> &counts) const
+{
+  const PacketVector &packets = m_trace->GetPackets ();
+  counts.assign (m_trace->GetTopology ().GetLinkCount (), 0);
+  for (GeometryVector::const_iterator g = m_frame.geometry.begin (); g != m_frame.geometry.end (); ++g)
+    {
+      for (uint32_t j = 0; j < (*g).GetSize (); ++j)
+        {
+          if ((*g).visible[j])
+            {
+              counts[packets[(*g).id[j]].GetLink ()]++;
+            }
+        }
+    }
+}
+
 void
 NamNetMotion::LoadMotion (Glib::RefPtr<Gio::DataInputStream> stream)
 {
-  std::string line;
-  uint32_t i1, i2;
-  NodeMap::iterator n1, n2;
-  EdgeVector::iterator e;
-  double time = 0;
-  char action;
+  Glib::RefPtr<NamTrace> trace = NamTrace::Create ();
+  trace->Load (stream);
+  SetTrace (trace);
+}
 
+void
+NamNetMotion::SetTrace (const Glib::RefPtr<NamTrace> &trace)
+{
   Stop ();
-  m_currentTime = 0;
-  m_nodes.clear ();
-  m_packets.clear ();
-  m_packetBuffer.clear ();
-  m_edges.clear ();
-
-  while (stream->read_line (line))
-    {
-      std::istringstream iss (line);
-      iss >> time >> action;
-
-      switch (action)
-      {
-        case 'N' :
-          {
-            Node node;
-            uint32_t id;
-            iss >> id >> node.x >> node.y;
-            m_nodes.insert (std::make_pair (id, node));
-            break;
-          }
-
-        case 'L' : // Edge
-          {
-            uint32_t i1, i2;
-            iss >> i1 >> i2;
-            n1 = m_nodes.find (i1);
-            n2 = m_nodes.find (i2);
-
-            if (n1 == m_nodes.end () || n2 == m_nodes.end ())
-              {
-                continue;
-              }
-
-            m_edges.push_back (Edge ((*n1).second, (*n2).second));
-            break;
-          }
-
-        case 'P' : // Packet
-          {
-            Packet packet;
-            packet.fbTx = time;
-            iss >> i1 >> i2 >> packet.lbTx >> packet.fbRx >> packet.lbRx;
-            n1 = m_nodes.find (i1);
-            n2 = m_nodes.find (i2);
-            if (n1 == m_nodes.end () || n2 == m_nodes.end ())
-              {
-                continue;
-              }
-
-            for (e = m_edges.begin (); e != m_edges.end (); ++e)
-              {
-                if ((*e).n1 == &(*n1).second && (*e).n2 == &(*n2).second)
-                  {
-                    packet.direction = 0;
-                    break;
-                  }
-                else if ((*e).n2 == &(*n1).second && (*e).n1 == &(*n2).second)
-                  {
-                    packet.direction = 1;
-                    break;
-                  }
-              }
-
-            if (e != m_edges.end ())
-              {
-                packet.edge = &(*e);
-                m_packets.push_back (packet);
-              }
-            break;
-          }
-
-        default:
-          break;
-      }
-    }
-
-  if (m_packets.size ())
-    {
-      m_lastTime = m_packets.back ().lbRx;
-    }
-  else
-    {
-      m_lastTime = 0;
-    }
+  m_settings.trace = trace;
+  m_settings.time = 0;
+  RequestChange (CHANGE_TRACE | CHANGE_TIME);
+}
 
-  m_packetIt = m_packets.begin ();
+Glib::RefPtr<NamTrace>
+NamNetMotion::GetTrace (void) const
+{
+  return m_settings.trace;
 }
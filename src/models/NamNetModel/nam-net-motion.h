@@ -29,10 +29,28 @@
 #include <gtkmm.h>
 #include "common.h"
 #include "motion.h"
+#include "spatial-grid.h"
+#include "nam-trace.h"
+#include "nam-packet-geometry.h"
 
 class NamNetMotion : public Motion
 {
 public:
+  /**
+   * \enum Packet colouring
+   */
+  enum ColorMode
+  {
+    /** every packet has the packet color */
+    COLOR_SINGLE,
+    /** by source and destination of the hop */
+    COLOR_BY_FLOW,
+    /** by link */
+    COLOR_BY_LINK,
+    /** by optional tag column following the packet times */
+    COLOR_BY_TAG
+  };
+
   virtual ~NamNetMotion ();
   /**
    * \param width link width
@@ -82,6 +100,30 @@ public:
    * \returns packet color
    */
   RgbaColor GetPacketColor (void) const;
+  /**
+   * \param mode packet colouring
+   */
+  void SetColorMode (ColorMode mode);
+  /**
+   * \returns packet colouring
+   */
+  ColorMode GetColorMode (void) const;
+  /**
+   * \param enable colour links by their utilisation instead of the link color
+   */
+  void SetHeatmap (bool enable);
+  /**
+   * \returns true if links are coloured by their utilisation
+   */
+  bool IsHeatmap (void) const;
+  /**
+   * \param window length of the utilisation window in trace seconds
+   */
+  void SetHeatmapWindow (double window);
+  /**
+   * \returns length of the utilisation window in trace seconds
+   */
+  double GetHeatmapWindow (void) const;
   /**
    * \param speed motion speed
    */
@@ -90,6 +132,23 @@ public:
    * \returns motion speed
    */
   double GetMotionSpeed (void) const;
+  /**
+   * \param pixels packet width on screen below which links show occupancy instead of packets
+   */
+  void SetLodThreshold (double pixels);
+  /**
+   * \returns level-of-detail threshold in pixels
+   */
+  double GetLodThreshold (void) const;
+  /**
+   * \param enable prepare the next frame on a worker thread while the
+   * current one is drawn, needs thread support
+   */
+  void SetPipelined (bool enable);
+  /**
+   * \returns true if frames are prepared on a worker thread
+   */
+  bool IsPipelined (void) const;
   /**
    * \returns current time
    */
@@ -99,43 +158,244 @@ public:
    */
   double GetLastTime (void) const;
   /**
-   * \brief load motion data
+   * \brief load motion data into a new trace
    */
   void LoadMotion (Glib::RefPtr<Gio::DataInputStream> stream);
+  /**
+   * \param trace loaded trace, may be shared with other views
+   *
+   * Stops the motion and rewinds it to the beginning of the trace.
+   */
+  void SetTrace (const Glib::RefPtr<NamTrace> &trace);
+  /**
+   * \returns trace shown by this view
+   */
+  Glib::RefPtr<NamTrace> GetTrace (void) const;
   /**
    * \brief seek view iterator over model
    */
   void Seek (double time);
 
   std::vector<Node> GetNodes (void) const;
+  /**
+   * \returns links of the drawn trace, valid until the next load
+   */
+  const std::vector<Edge> &GetEdges (void) const;
+  /**
+   * \param counts number of packets on every link in the current frame
+   *
+   * Must be called from the thread which enters frames.
+   */
+  void GetOccupancy (std::vector<uint32_t> &counts) const;
 
   virtual void EnterFrame (uint32_t rate);
+  virtual void EnterFrames (uint32_t rate, uint32_t count);
   virtual void DrawFrame (const Cairo::RefPtr<Cairo::Context> &context);
+  /**
+   * \brief hit test nodes, then packets, then links
+   */
+  virtual bool Pick (double x, double y, double tolerance, Glib::ustring &info);
+  /**
+   * \brief report active packets and how many of them are visible
+   */
+  virtual void GetStatistics (const Cairo::Matrix &matrix, int width, int height, Glib::ustring &text) const;
+  virtual bool GetDamage (const Cairo::Matrix &matrix, uint32_t rate, Gdk::Region &region);
+  /**
+   * \brief apply the trace, colouring, heatmap, style, degradation and time requested while the frame was drawn
+   */
+  virtual bool ApplyChanges (void);
 
   static Glib::RefPtr<NamNetMotion> Create (void);
 protected:
   NamNetMotion ();
+  /**
+   * \brief any degradation switches links to occupancy bars
+   */
+  virtual void Degrade (uint32_t level);
 
 private:
-  typedef std::map<uint32_t, Node> NodeMap;
-  typedef std::list<Packet> PacketList;
-  typedef std::vector<Packet> PacketVector;
-  typedef std::vector<Edge> EdgeVector;
+  /**
+   * \brief user space bounding box of the clip
+   */
+  struct Bounds
+  {
+    double left;
+    double top;
+    double right;
+    double bottom;
+    /**
+     * \returns true if segment stroked with given width may be visible
+     */
+    bool Intersects (double x1, double y1, double x2, double y2, double width) const;
+  };
+
+  /**
+   * \enum Settings requested on the GTK thread and not applied yet
+   */
+  enum Change
+  {
+    CHANGE_TRACE = 1,
+    CHANGE_COLOR_MODE = 2,
+    CHANGE_HEATMAP = 4,
+    CHANGE_TIME = 8,
+    CHANGE_STYLE = 16, // widths, colours and level of detail
+    CHANGE_DEGRADATION = 32
+  };
+
+  /**
+   * \brief last requested settings, equal to the applied ones unless changed
+   */
+  struct Settings
+  {
+    Settings ();
+
+    Glib::RefPtr<NamTrace> trace;
+    ColorMode colorMode;
+    bool      heatmap;
+    double    heatmapWindow;
+    double    time; // valid while CHANGE_TIME is set
+    double    edgeWidth;
+    double    nodeWidth;
+    double    packetWidth;
+    double    lodThreshold;
+    RgbaColor edgeColor;
+    RgbaColor nodeColor;
+    RgbaColor packetColor;
+    bool      degraded;
+  };
+
+  typedef std::vector<uint32_t> CounterVector;
+  typedef std::vector<PacketGeometry> GeometryVector;
+
+  /**
+   * \brief packets of a view at one time and their segments
+   */
+  struct Frame
+  {
+    Frame ();
+    /**
+     * \brief empty the buffer and rewind to the beginning of the trace
+     */
+    void Reset (void);
+    /**
+     * \brief exchange contents with frame in constant time
+     */
+    void Swap (Frame &frame);
+
+    const NamTrace *trace; // trace the buffer is filled from, kept alive by the view
+    ColorMode      colorMode; // colouring of the buffered packets
+    uint32_t       serial; // settings serial of trace and colorMode
+    double         time;
+    uint32_t       nextPacket; // first packet of the trace not yet in the buffer
+    GeometryVector geometry; // packets in flight and their segments per palette index, in trace order
+  };
+
+  /**
+   * \param scale pixels per unit
+   * \returns true if links are drawn as occupancy bars at this scale
+   */
+  bool UseOccupancy (double scale) const;
+  /**
+   * Builds the spatial index of packets in the current frame
+   */
+  void BuildPacketIndex (void);
+  /**
+   * Moves frame to time: drops received packets from the buffer, adds the
+   * packets in flight and computes their segments. Cheap when the time
+   * grows, rewinds the buffer otherwise. Only reads the frame and its
+   * trace, so the worker thread may call it for m_next.
+   */
+  void UpdateBuffer (Frame &frame, double time) const;
+  /**
+   * \brief apply now if the render thread doesn't draw the motion, otherwise
+   * leave the change to the next ApplyChanges
+   * \param change Change flags set in m_settings
+   */
+  void RequestChange (uint32_t change);
+  /**
+   * \brief ask the worker to prepare m_next for time with the settings of
+   * m_frame, unless it is busy or the frame is already prepared
+   */
+  void RequestFrame (double time);
+  void RunWorker (void);
+  /**
+   * \param topology
+   * \param packet
+   * \param x
+   * \param y origin of the hop
+   * \param dx
+   * \param dy vector from the origin to the target of the hop
+   */
+  static void GetHop (const NamTopology &topology, const Packet &packet, double &x, double &y, double &dx, double &dy);
+  /**
+   * Updates the utilisation of every link for the current time
+   */
+  void UpdateUtilisation (void);
+  /**
+   * \returns palette index of packet in colour mode
+   */
+  static uint16_t GetColorIndex (const Packet &packet, uint32_t tag, ColorMode mode);
+  /**
+   * \returns colour of palette index
+   */
+  RgbaColor GetPaletteColor (uint16_t index) const;
+  void DrawHeatmap (const Cairo::RefPtr<Cairo::Context> &context, const Bounds &clip) const;
+  void DrawPackets (const Cairo::RefPtr<Cairo::Context> &context, const Bounds &clip) const;
+  void DrawOccupancy (const Cairo::RefPtr<Cairo::Context> &context, const Bounds &clip) const;
+  /**
+   * \returns false if packet is not in flight at the given time
+   * Computes the segment of the link occupied by packet
+   */
+  bool GetPacketSegment (const Packet &packet, double time, Point &from, Point &to) const;
+
+  typedef NamTrace::NodeMap NodeMap;
+  typedef NamTrace::PacketVector PacketVector;
+  typedef std::vector<float> RatioVector;
+  typedef std::vector<std::pair<uint16_t, uint32_t> > PacketRefVector; // palette and geometry index
 
-  double          m_currentTime;
-  double          m_lastTime;
+  Glib::RefPtr<NamTrace> m_trace; // shared with other views, never modified
   double          m_speed;
   double          m_edgeWidth;
   double          m_nodeWidth;
   double          m_packetWidth;
+  double          m_lodThreshold;
+  bool            m_degraded; // frames exceed the budget, applied from m_settings
   RgbaColor       m_edgeColor;
   RgbaColor       m_nodeColor;
   RgbaColor       m_packetColor;
-  NodeMap         m_nodes;
-  EdgeVector      m_edges;
-  PacketList      m_packetBuffer; // currently visible packets
-  PacketVector    m_packets; // all packets
-  PacketVector::iterator m_packetIt;
+  ColorMode       m_colorMode;
+  bool            m_heatmap;
+  double          m_heatmapWindow;
+  Frame           m_frame; // current frame
+  // Changes of a threaded motion wait until the render thread has drawn
+  // the frame; GTK thread only, like every writer of the state above.
+  Settings        m_settings;
+  uint32_t        m_changes; // Change flags
+  CounterVector   m_headCursors; // per series cursor at the window end
+  CounterVector   m_tailCursors; // per series cursor at the window start
+  RatioVector     m_utilisation; // per link
+  SpatialGrid     m_packetGrid; // items index m_packetRefs
+  PacketRefVector m_packetRefs;
+  uint32_t        m_frameSerial; // changes whenever the packet buffer changes
+  uint32_t        m_packetGridSerial; // frame serial m_packetGrid was built for
+  uint32_t        m_settingsSerial; // changes with the trace or colouring of m_frame
+  // Pipelining: the worker prepares m_next while m_frame is drawn. The
+  // buffers are exchanged without locking: the worker sets m_nextReady
+  // when done and doesn't touch m_next again until the next request.
+  // The worker only holds the mutex to take a request, so the GTK thread
+  // never waits for it; a frame prepared for other settings is stale.
+  Frame           m_next;
+  Glib::Thread   *m_worker;
+  Glib::Mutex     m_workerMutex; // guards the request fields below
+  Glib::Cond      m_workerCond;
+  bool            m_workerQuit;
+  bool            m_workerBusy; // the worker writes m_next
+  bool            m_requested;
+  double          m_requestTime;
+  Glib::RefPtr<NamTrace> m_requestTrace; // released on the GTK thread only
+  ColorMode       m_requestColorMode;
+  uint32_t        m_requestSerial;
+  volatile gint   m_nextReady;
   SignalEnterFrame m_signalEnterFrame;
 };
 
@@ -0,0 +1,254 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+
+#if defined (__AVX__)
+#include <immintrin.h>
+#elif defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "nam-packet-geometry.h"
+
+PacketGeometry::PacketGeometry ()
+{
+}
+
+void
+PacketGeometry::Clear (void)
+{
+  fbTx.clear ();
+  lbTx.clear ();
+  fbRx.clear ();
+  lbRx.clear ();
+  x.clear ();
+  y.clear ();
+  dx.clear ();
+  dy.clear ();
+  id.clear ();
+}
+
+void
+PacketGeometry::Swap (PacketGeometry &geometry)
+{
+  fbTx.swap (geometry.fbTx);
+  lbTx.swap (geometry.lbTx);
+  fbRx.swap (geometry.fbRx);
+  lbRx.swap (geometry.lbRx);
+  x.swap (geometry.x);
+  y.swap (geometry.y);
+  dx.swap (geometry.dx);
+  dy.swap (geometry.dy);
+  id.swap (geometry.id);
+  x1.swap (geometry.x1);
+  y1.swap (geometry.y1);
+  x2.swap (geometry.x2);
+  y2.swap (geometry.y2);
+  visible.swap (geometry.visible);
+}
+
+void
+PacketGeometry::Add (const Packet &packet, double ox, double oy, double vx, double vy, uint32_t index)
+{
+  fbTx.push_back (packet.GetFirstBitTx ());
+  lbTx.push_back (packet.GetLastBitTx ());
+  fbRx.push_back (packet.GetFirstBitRx ());
+  lbRx.push_back (packet.GetLastBitRx ());
+  x.push_back (ox);
+  y.push_back (oy);
+  dx.push_back (vx);
+  dy.push_back (vy);
+  id.push_back (index);
+}
+
+void
+PacketGeometry::RemoveReceived (double time)
+{
+  uint32_t n = GetSize ();
+  uint32_t last = 0;
+  while (last < n && lbRx[last] > time)
+    {
+      last++;
+    }
+
+  // compact the tail in place, most frames receive nothing and stop above
+  for (uint32_t i = last; i < n; ++i)
+    {
+      if (lbRx[i] > time)
+        {
+          fbTx[last] = fbTx[i];
+          lbTx[last] = lbTx[i];
+          fbRx[last] = fbRx[i];
+          lbRx[last] = lbRx[i];
+          x[last] = x[i];
+          y[last] = y[i];
+          dx[last] = dx[i];
+          dy[last] = dy[i];
+          id[last] = id[i];
+          last++;
+        }
+    }
+
+  if (last < n)
+    {
+      fbTx.resize (last);
+      lbTx.resize (last);
+      fbRx.resize (last);
+      lbRx.resize (last);
+      x.resize (last);
+      y.resize (last);
+      dx.resize (last);
+      dy.resize (last);
+      id.resize (last);
+    }
+}
+
+uint32_t
+PacketGeometry::GetSize (void) const
+{
+  return fbTx.size ();
+}
+
+const char *
+PacketGeometry::GetKernelName (void)
+{
+#if defined (__AVX__)
+  return "avx";
+#elif defined (__SSE2__)
+  return "sse2";
+#else
+  return "scalar";
+#endif
+}
+
+bool
+PacketGeometry::GetSegment (uint32_t i, double time, Point &from, Point &to) const
+{
+  if (lbRx[i] <= time || fbTx[i] > time)
+    {
+      return false;
+    }
+
+  double txTime = std::min (lbTx[i], time) - fbTx[i] - std::max (0.0, time - fbRx[i]);
+  double delay = fbRx[i] - fbTx[i];
+  double begin = std::max (0.0, time - lbTx[i]) / delay;
+  double end = begin + txTime / delay;
+  from = Point (x[i] + dx[i] * begin, y[i] + dy[i] * begin);
+  to = Point (x[i] + dx[i] * end, y[i] + dy[i] * end);
+  return true;
+}
+
+void
+PacketGeometry::ComputeRange (double time, uint32_t begin, uint32_t end)
+{
+  // the arithmetic of NamNetMotion::GetPacketSegment without branches
+  for (uint32_t i = begin; i < end; ++i)
+    {
+      double txTime = std::min (lbTx[i], time) - fbTx[i] - std::max (0.0, time - fbRx[i]);
+      double delay = fbRx[i] - fbTx[i];
+      double from = std::max (0.0, time - lbTx[i]) / delay;
+      double to = from + txTime / delay;
+
+      x1[i] = x[i] + dx[i] * from;
+      y1[i] = y[i] + dy[i] * from;
+      x2[i] = x[i] + dx[i] * to;
+      y2[i] = y[i] + dy[i] * to;
+      visible[i] = lbRx[i] > time && fbTx[i] <= time;
+    }
+}
+
+void
+PacketGeometry::Compute (double time)
+{
+  uint32_t n = GetSize ();
+  x1.resize (n);
+  y1.resize (n);
+  x2.resize (n);
+  y2.resize (n);
+  visible.resize (n);
+
+  uint32_t i = 0;
+#if defined (__AVX__)
+  __m256d t = _mm256_set1_pd (time);
+  __m256d zero = _mm256_setzero_pd ();
+  for (; i + 4 <= n; i += 4)
+    {
+      __m256d ftx = _mm256_loadu_pd (&fbTx[i]);
+      __m256d ltx = _mm256_loadu_pd (&lbTx[i]);
+      __m256d frx = _mm256_loadu_pd (&fbRx[i]);
+      __m256d lrx = _mm256_loadu_pd (&lbRx[i]);
+
+      __m256d txTime = _mm256_sub_pd (_mm256_sub_pd (_mm256_min_pd (ltx, t), ftx),
+                                      _mm256_max_pd (zero, _mm256_sub_pd (t, frx)));
+      __m256d delay = _mm256_sub_pd (frx, ftx);
+      __m256d from = _mm256_div_pd (_mm256_max_pd (zero, _mm256_sub_pd (t, ltx)), delay);
+      __m256d to = _mm256_add_pd (from, _mm256_div_pd (txTime, delay));
+
+      __m256d ox = _mm256_loadu_pd (&x[i]);
+      __m256d oy = _mm256_loadu_pd (&y[i]);
+      __m256d vx = _mm256_loadu_pd (&dx[i]);
+      __m256d vy = _mm256_loadu_pd (&dy[i]);
+      _mm256_storeu_pd (&x1[i], _mm256_add_pd (ox, _mm256_mul_pd (vx, from)));
+      _mm256_storeu_pd (&y1[i], _mm256_add_pd (oy, _mm256_mul_pd (vy, from)));
+      _mm256_storeu_pd (&x2[i], _mm256_add_pd (ox, _mm256_mul_pd (vx, to)));
+      _mm256_storeu_pd (&y2[i], _mm256_add_pd (oy, _mm256_mul_pd (vy, to)));
+
+      int mask = _mm256_movemask_pd (_mm256_and_pd (_mm256_cmp_pd (lrx, t, _CMP_GT_OQ),
+                                                    _mm256_cmp_pd (ftx, t, _CMP_LE_OQ)));
+      visible[i] = mask & 1;
+      visible[i + 1] = (mask >> 1) & 1;
+      visible[i + 2] = (mask >> 2) & 1;
+      visible[i + 3] = (mask >> 3) & 1;
+    }
+#elif defined (__SSE2__)
+  __m128d t = _mm_set1_pd (time);
+  __m128d zero = _mm_setzero_pd ();
+  for (; i + 2 <= n; i += 2)
+    {
+      __m128d ftx = _mm_loadu_pd (&fbTx[i]);
+      __m128d ltx = _mm_loadu_pd (&lbTx[i]);
+      __m128d frx = _mm_loadu_pd (&fbRx[i]);
+      __m128d lrx = _mm_loadu_pd (&lbRx[i]);
+
+      __m128d txTime = _mm_sub_pd (_mm_sub_pd (_mm_min_pd (ltx, t), ftx),
+                                   _mm_max_pd (zero, _mm_sub_pd (t, frx)));
+      __m128d delay = _mm_sub_pd (frx, ftx);
+      __m128d from = _mm_div_pd (_mm_max_pd (zero, _mm_sub_pd (t, ltx)), delay);
+      __m128d to = _mm_add_pd (from, _mm_div_pd (txTime, delay));
+
+      __m128d ox = _mm_loadu_pd (&x[i]);
+      __m128d oy = _mm_loadu_pd (&y[i]);
+      __m128d vx = _mm_loadu_pd (&dx[i]);
+      __m128d vy = _mm_loadu_pd (&dy[i]);
+      _mm_storeu_pd (&x1[i], _mm_add_pd (ox, _mm_mul_pd (vx, from)));
+      _mm_storeu_pd (&y1[i], _mm_add_pd (oy, _mm_mul_pd (vy, from)));
+      _mm_storeu_pd (&x2[i], _mm_add_pd (ox, _mm_mul_pd (vx, to)));
+      _mm_storeu_pd (&y2[i], _mm_add_pd (oy, _mm_mul_pd (vy, to)));
+
+      int mask = _mm_movemask_pd (_mm_and_pd (_mm_cmpgt_pd (lrx, t), _mm_cmple_pd (ftx, t)));
+      visible[i] = mask & 1;
+      visible[i + 1] = (mask >> 1) & 1;
+    }
+#endif
+
+  // the tail, or everything without vector instructions
+  ComputeRange (time, i, n);
+}
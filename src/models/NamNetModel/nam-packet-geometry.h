@@ -0,0 +1,111 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef NAM_PACKET_GEOMETRY_H
+#define NAM_PACKET_GEOMETRY_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "common.h"
+
+/**
+ * \brief Active packets in structure-of-arrays layout and the segments they occupy
+ *
+ * Packets are added with the origin and the vector to the target of their
+ * hop as they are admitted, and removed once received, so the arrays persist
+ * from frame to frame. Compute evaluates the segment of every packet at a
+ * given time in one pass, with AVX or SSE2 when the compiler targets them
+ * and a scalar loop otherwise, so drawing only reads the vertex arrays.
+ */
+class PacketGeometry
+{
+public:
+  PacketGeometry ();
+  /**
+   * \brief remove all packets
+   */
+  void Clear (void);
+  /**
+   * \brief exchange packets and segments with geometry
+   */
+  void Swap (PacketGeometry &geometry);
+  /**
+   * \param packet
+   * \param x
+   * \param y origin of the hop
+   * \param dx
+   * \param dy vector from the origin to the target of the hop
+   * \param id index of the packet in the trace
+   */
+  void Add (const Packet &packet, double x, double y, double dx, double dy, uint32_t id);
+  /**
+   * \brief remove packets received by time, keeping the order of the others
+   * \param time trace time
+   */
+  void RemoveReceived (double time);
+  /**
+   * \returns number of packets
+   */
+  uint32_t GetSize (void) const;
+  /**
+   * \param time trace time
+   *
+   * Fills x1, y1, x2, y2 with the occupied segments and visible with 1
+   * for packets in flight at time, 0 for the others.
+   */
+  void Compute (double time);
+  /**
+   * \brief evaluate the segment of one packet at any time, e.g. the next frame
+   * \param i packet index
+   * \param time trace time
+   * \param from
+   * \param to ends of the segment
+   * \returns false if the packet is not in flight at time
+   */
+  bool GetSegment (uint32_t i, double time, Point &from, Point &to) const;
+  /**
+   * \returns name of the instruction set used by Compute
+   */
+  static const char *GetKernelName (void);
+
+public:
+  // inputs
+  std::vector<double>   fbTx;
+  std::vector<double>   lbTx;
+  std::vector<double>   fbRx;
+  std::vector<double>   lbRx;
+  std::vector<double>   x;
+  std::vector<double>   y;
+  std::vector<double>   dx;
+  std::vector<double>   dy;
+  std::vector<uint32_t> id;
+  // outputs
+  std::vector<double>   x1;
+  std::vector<double>   y1;
+  std::vector<double>   x2;
+  std::vector<double>   y2;
+  std::vector<uint8_t>  visible;
+
+private:
+  void ComputeRange (double time, uint32_t begin, uint32_t end);
+};
+
+#endif /* NAM_PACKET_GEOMETRY_H */
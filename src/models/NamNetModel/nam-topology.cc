@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <cmath>
+
+#include "nam-topology.h"
+
+NamTopology::NamTopology ()
+{
+}
+
+void
+NamTopology::Build (const std::map<uint32_t, Node> &nodes, const std::vector<Edge> &edges)
+{
+  std::map<const Node *, uint32_t> indices;
+
+  nodeId.clear ();
+  nodeX.clear ();
+  nodeY.clear ();
+  for (std::map<uint32_t, Node>::const_iterator i = nodes.begin (); i != nodes.end (); ++i)
+    {
+      indices[&(*i).second] = nodeId.size ();
+      nodeId.push_back ((*i).first);
+      nodeX.push_back ((*i).second.x);
+      nodeY.push_back ((*i).second.y);
+    }
+
+  uint32_t links = edges.size ();
+  linkFrom.resize (links);
+  linkTo.resize (links);
+  linkLength.resize (links);
+  linkCos.resize (links);
+  linkSin.resize (links);
+  for (uint32_t j = 0; j < links; ++j)
+    {
+      uint32_t from = indices[edges[j].n1];
+      uint32_t to = indices[edges[j].n2];
+      double dx = nodeX[to] - nodeX[from];
+      double dy = nodeY[to] - nodeY[from];
+      double length = std::sqrt (dx * dx + dy * dy);
+
+      linkFrom[j] = from;
+      linkTo[j] = to;
+      linkLength[j] = length;
+      // a zero length link keeps a valid direction
+      linkCos[j] = length > 0 ? dx / length : 1;
+      linkSin[j] = length > 0 ? dy / length : 0;
+    }
+}
+
+uint32_t
+NamTopology::GetNodeCount (void) const
+{
+  return nodeId.size ();
+}
+
+uint32_t
+NamTopology::GetLinkCount (void) const
+{
+  return linkFrom.size ();
+}
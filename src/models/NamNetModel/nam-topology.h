@@ -0,0 +1,68 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef NAM_TOPOLOGY_H
+#define NAM_TOPOLOGY_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+#include "common.h"
+
+/**
+ * \brief Structure-of-arrays copy of the nodes and links of a trace
+ *
+ * Node i is at (nodeX[i], nodeY[i]), nodes are ordered by id. Link j goes
+ * from node linkFrom[j] to node linkTo[j] along the unit vector
+ * (linkCos[j], linkSin[j]) and has length linkLength[j], links keep the
+ * order of the trace. Loops over the topology read contiguous arrays and
+ * packet positions need no trigonometry.
+ */
+class NamTopology
+{
+public:
+  NamTopology ();
+  /**
+   * \param nodes nodes by id
+   * \param edges links between the nodes
+   */
+  void Build (const std::map<uint32_t, Node> &nodes, const std::vector<Edge> &edges);
+  /**
+   * \returns number of nodes
+   */
+  uint32_t GetNodeCount (void) const;
+  /**
+   * \returns number of links
+   */
+  uint32_t GetLinkCount (void) const;
+
+public:
+  std::vector<uint32_t> nodeId;
+  std::vector<double>   nodeX;
+  std::vector<double>   nodeY;
+  std::vector<uint32_t> linkFrom;
+  std::vector<uint32_t> linkTo;
+  std::vector<double>   linkLength;
+  std::vector<double>   linkCos;
+  std::vector<double>   linkSin;
+};
+
+#endif /* NAM_TOPOLOGY_H */
@@ -0,0 +1,249 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include "nam-trace.h"
+
+NamTrace::NamTrace ()
+  : m_lastTime (0)
+{
+}
+
+NamTrace::~NamTrace ()
+{
+}
+
+Glib::RefPtr<NamTrace>
+NamTrace::Create (void)
+{
+  return Glib::RefPtr<NamTrace> (new NamTrace ());
+}
+
+void
+NamTrace::Load (Glib::RefPtr<Gio::DataInputStream> stream)
+{
+  std::string line;
+  uint32_t i1, i2;
+  NodeMap::iterator n1, n2;
+  EdgeVector::iterator e;
+  double time = 0;
+  char action;
+
+  m_nodes.clear ();
+  m_packets.clear ();
+  m_tags.clear ();
+  m_edges.clear ();
+
+  while (stream->read_line (line))
+    {
+      std::istringstream iss (line);
+      iss >> time >> action;
+
+      switch (action)
+      {
+        case 'N' :
+          {
+            Node node;
+            uint32_t id;
+            iss >> id >> node.x >> node.y;
+            m_nodes.insert (std::make_pair (id, node));
+            break;
+          }
+
+        case 'L' : // Edge
+          {
+            uint32_t i1, i2;
+            iss >> i1 >> i2;
+            n1 = m_nodes.find (i1);
+            n2 = m_nodes.find (i2);
+
+            if (n1 == m_nodes.end () || n2 == m_nodes.end ())
+              {
+                continue;
+              }
+
+            m_edges.push_back (Edge ((*n1).second, (*n2).second));
+            break;
+          }
+
+        case 'P' : // Packet
+          {
+            double lbTx, fbRx, lbRx;
+            uint32_t direction = 0;
+            uint32_t tag = 0;
+            iss >> i1 >> i2 >> lbTx >> fbRx >> lbRx >> tag;
+            n1 = m_nodes.find (i1);
+            n2 = m_nodes.find (i2);
+            if (n1 == m_nodes.end () || n2 == m_nodes.end ())
+              {
+                continue;
+              }
+
+            for (e = m_edges.begin (); e != m_edges.end (); ++e)
+              {
+                if ((*e).n1 == &(*n1).second && (*e).n2 == &(*n2).second)
+                  {
+                    direction = 0;
+                    break;
+                  }
+                else if ((*e).n2 == &(*n1).second && (*e).n1 == &(*n2).second)
+                  {
+                    direction = 1;
+                    break;
+                  }
+              }
+
+            if (e != m_edges.end ())
+              {
+                m_packets.push_back (Packet (e - m_edges.begin (), direction, time, lbTx, fbRx, lbRx));
+                m_tags.push_back (tag);
+              }
+            break;
+          }
+
+        default:
+          break;
+      }
+    }
+
+  if (m_packets.size ())
+    {
+      m_lastTime = m_packets.back ().GetLastBitRx ();
+    }
+  else
+    {
+      m_lastTime = 0;
+    }
+
+  // packets are sorted by the first bit, so a prefix maximum of the
+  // reception time tells where the packets in flight at any time begin
+  m_reach.resize (m_packets.size ());
+  for (uint32_t i = 0; i < m_packets.size (); ++i)
+    {
+      m_reach[i] = i ? std::max (m_reach[i - 1], m_packets[i].GetLastBitRx ()) : m_packets[i].GetLastBitRx ();
+    }
+
+  m_topology.Build (m_nodes, m_edges);
+  m_busy.Build (m_packets, 2 * m_edges.size ());
+  BuildPickIndex ();
+}
+
+const NamTrace::NodeMap &
+NamTrace::GetNodes (void) const
+{
+  return m_nodes;
+}
+
+const NamTrace::EdgeVector &
+NamTrace::GetEdges (void) const
+{
+  return m_edges;
+}
+
+const NamTrace::PacketVector &
+NamTrace::GetPackets (void) const
+{
+  return m_packets;
+}
+
+uint32_t
+NamTrace::GetTag (uint32_t packet) const
+{
+  return m_tags[packet];
+}
+
+const NamTopology &
+NamTrace::GetTopology (void) const
+{
+  return m_topology;
+}
+
+double
+NamTrace::GetLastTime (void) const
+{
+  return m_lastTime;
+}
+
+const Rectangle &
+NamTrace::GetExtent (void) const
+{
+  return m_extent;
+}
+
+const SpatialGrid &
+NamTrace::GetNodeGrid (void) const
+{
+  return m_nodeGrid;
+}
+
+const SpatialGrid &
+NamTrace::GetEdgeGrid (void) const
+{
+  return m_edgeGrid;
+}
+
+uint32_t
+NamTrace::FindPacket (double time) const
+{
+  return std::upper_bound (m_reach.begin (), m_reach.end (), time) - m_reach.begin ();
+}
+
+uint32_t
+NamTrace::GetBusyCursor (uint32_t series) const
+{
+  return m_busy.GetCursor (series);
+}
+
+double
+NamTrace::GetBusyTime (uint32_t series, double time, uint32_t &cursor) const
+{
+  return m_busy.GetBusyTime (series, time, cursor);
+}
+
+void
+NamTrace::BuildPickIndex (void)
+{
+  const NamTopology &t = m_topology;
+
+  m_extent = Rectangle ();
+  for (uint32_t i = 0; i < t.GetNodeCount (); ++i)
+    {
+      if (i == 0 || t.nodeX[i] < m_extent.left) m_extent.left = t.nodeX[i];
+      if (i == 0 || t.nodeY[i] < m_extent.top) m_extent.top = t.nodeY[i];
+      if (i == 0 || t.nodeX[i] > m_extent.right) m_extent.right = t.nodeX[i];
+      if (i == 0 || t.nodeY[i] > m_extent.bottom) m_extent.bottom = t.nodeY[i];
+    }
+
+  m_nodeGrid.Reset (m_extent.left, m_extent.top, m_extent.right, m_extent.bottom, t.GetNodeCount ());
+  for (uint32_t i = 0; i < t.GetNodeCount (); ++i)
+    {
+      m_nodeGrid.AddPoint (i, t.nodeX[i], t.nodeY[i]);
+    }
+  m_nodeGrid.Finalize ();
+
+  m_edgeGrid.Reset (m_extent.left, m_extent.top, m_extent.right, m_extent.bottom, t.GetLinkCount ());
+  for (uint32_t j = 0; j < t.GetLinkCount (); ++j)
+    {
+      m_edgeGrid.AddSegment (j, t.nodeX[t.linkFrom[j]], t.nodeY[t.linkFrom[j]], t.nodeX[t.linkTo[j]], t.nodeY[t.linkTo[j]]);
+    }
+  m_edgeGrid.Finalize ();
+}
@@ -0,0 +1,134 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2010 Andrey Churin
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: Andrey Churin <aachurin@gmail.com>
+ */
+
+#ifndef NAM_TRACE_H
+#define NAM_TRACE_H
+
+#include <stdint.h>
+#include <vector>
+#include <map>
+
+#include <gtkmm.h>
+#include "common.h"
+#include "spatial-grid.h"
+#include "nam-busy-time.h"
+#include "nam-topology.h"
+
+/**
+ * \brief Topology, packets and indices of a loaded NAM trace
+ *
+ * The trace is immutable once loaded, so any number of NamNetMotion
+ * views, in any thread, may share it. Everything which depends on the
+ * current time of a view (cursors, the active packets) lives in the view.
+ */
+class NamTrace : public Glib::Object
+{
+public:
+  typedef std::map<uint32_t, Node> NodeMap;
+  typedef std::vector<Edge> EdgeVector;
+  typedef std::vector<Packet> PacketVector;
+
+  virtual ~NamTrace ();
+  /**
+   * \brief parse the trace, must be done before the trace is shared
+   */
+  void Load (Glib::RefPtr<Gio::DataInputStream> stream);
+  /**
+   * \returns nodes by id
+   */
+  const NodeMap &GetNodes (void) const;
+  /**
+   * \returns links
+   */
+  const EdgeVector &GetEdges (void) const;
+  /**
+   * \returns packets sorted by the first bit transmission time
+   */
+  const PacketVector &GetPackets (void) const;
+  /**
+   * \param packet packet index
+   * \returns value of the optional tag column
+   */
+  uint32_t GetTag (uint32_t packet) const;
+  /**
+   * \returns nodes and links as contiguous arrays
+   */
+  const NamTopology &GetTopology (void) const;
+  /**
+   * \returns last bit reception time of the last packet
+   */
+  double GetLastTime (void) const;
+  /**
+   * \returns bounding box of nodes
+   */
+  const Rectangle &GetExtent (void) const;
+  /**
+   * \returns spatial index of nodes, items are topology node indices
+   */
+  const SpatialGrid &GetNodeGrid (void) const;
+  /**
+   * \returns spatial index of links, items are link indices
+   */
+  const SpatialGrid &GetEdgeGrid (void) const;
+  /**
+   * \param time trace time
+   * \returns index of the first packet which may be in flight at time or later
+   */
+  uint32_t FindPacket (double time) const;
+  /**
+   * \param series link direction (2 * link + direction)
+   * \returns cursor positioned before the first busy interval of series
+   */
+  uint32_t GetBusyCursor (uint32_t series) const;
+  /**
+   * \param series link direction (2 * link + direction)
+   * \param time trace time
+   * \param cursor first interval starting after the previous query time, updated
+   * \returns total transmission time on the link direction up to time
+   */
+  double GetBusyTime (uint32_t series, double time, uint32_t &cursor) const;
+
+  static Glib::RefPtr<NamTrace> Create (void);
+protected:
+  NamTrace ();
+
+private:
+  /**
+   * Builds the spatial index of nodes and links
+   */
+  void BuildPickIndex (void);
+
+  typedef std::vector<uint32_t> TagVector;
+  typedef std::vector<double> TimeVector;
+
+  double          m_lastTime;
+  NodeMap         m_nodes;
+  EdgeVector      m_edges;
+  NamTopology     m_topology;
+  PacketVector    m_packets;
+  TagVector       m_tags; // tag column of each packet
+  TimeVector      m_reach; // latest last bit reception of packets up to each index
+  NamBusyTime     m_busy; // busy intervals of link directions
+  Rectangle       m_extent;
+  SpatialGrid     m_nodeGrid;
+  SpatialGrid     m_edgeGrid;
+};
+
+#endif /* NAM_TRACE_H */